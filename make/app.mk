@@ -52,6 +52,12 @@ CDEFS += \
 	CONFIG_FS_CMD_THRD_LIST=1
 endif
 
+# The frozen uasyncio module imports socket and select, and is only
+# included in applications that enable it.
+ifneq ($(filter CONFIG_PUMBAA_MODULE_UASYNCIO=1,$(CDEFS)),)
+PYSRC += $(PUMBAA_ROOT)/src/py/uasyncio.py
+endif
+
 MAIN_C ?= $(PUMBAA_ROOT)/src/main.c
 FROZEN_C = $(GENDIR)/frozen.c
 FROZEN_MPY_C = $(GENDIR)/frozen_mpy.c
@@ -81,6 +87,18 @@ MAKEQSTRDEFS_PY = $(MICROPYTHON_ROOT)/py/makeqstrdefs.py
 MPY_CROSS = $(PUMBAA_ROOT)/bin/mpy-cross-$(shell uname -m)-linux
 MPY_TOOL_PY = $(MICROPYTHON_ROOT)/tools/mpy-tool.py
 
+# Smaller SSL record buffers on ESP32, where
+# CONFIG_PUMBAA_SSL_LOW_RAM is enabled by default. The define is given
+# to both the mbedtls library and Pumbaa, as they must agree on the
+# buffer size. It must be at least
+# CONFIG_PUMBAA_SSL_MAX_FRAGMENT_LENGTH.
+ifeq ($(ARCH),esp32)
+ifeq ($(filter CONFIG_PUMBAA_SSL_LOW_RAM=0,$(CDEFS)),)
+PUMBAA_SSL_MAX_CONTENT_LEN ?= 4096
+CDEFS += MBEDTLS_SSL_MAX_CONTENT_LEN=$(PUMBAA_SSL_MAX_CONTENT_LEN)
+endif
+endif
+
 ifneq ($(ARCH),esp)
 LIB += m
 CDEFS += \
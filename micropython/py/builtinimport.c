@@ -242,6 +242,19 @@ STATIC void do_load(mp_obj_t module_obj, vstr_t *file) {
     // If we can compile scripts then load the file and compile and execute it.
     #if MICROPY_ENABLE_COMPILER
     {
+        #ifdef MICROPY_PORT_IMPORT_LOAD_RAW_CODE
+        // The port may provide the compiled module, for example from a
+        // bytecode cache. NULL means compile the source as usual.
+        mp_raw_code_t *raw_code = MICROPY_PORT_IMPORT_LOAD_RAW_CODE(file_str);
+        if (raw_code != NULL) {
+            #if MICROPY_PY___FILE__
+            mp_store_attr(module_obj, MP_QSTR___file__, MP_OBJ_NEW_QSTR(qstr_from_str(file_str)));
+            #endif
+            do_execute_raw_code(module_obj, raw_code);
+            return;
+        }
+        #endif
+
         mp_lexer_t *lex = mp_lexer_new_from_file(file_str);
         do_load_from_lexer(module_obj, lex, file_str);
         return;
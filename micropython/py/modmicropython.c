@@ -76,6 +76,9 @@ mp_obj_t mp_micropython_mem_info(size_t n_args, const mp_obj_t *args) {
 #endif
 #if MICROPY_ENABLE_GC
     gc_dump_info();
+#ifdef MICROPY_PORT_MEM_INFO
+    MICROPY_PORT_MEM_INFO
+#endif
     if (n_args == 1) {
         // arg given means dump gc allocation table
         gc_dump_alloc_table();
@@ -53,6 +53,9 @@ static const FAR char *help_text_p =
 static mp_obj_t builtin_help(size_t n_args, const mp_obj_t *args_p)
 {
     if (n_args == 0) {
+        /* Written directly to the output channel, after any buffered
+           output. */
+        mp_hal_stdout_flush();
         std_printf(help_text_p);
     } else {
         pyhelp_print_obj(args_p[0]);
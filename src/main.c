@@ -38,6 +38,8 @@ static char heap[CONFIG_PUMBAA_HEAP_SIZE];
  */
 static void print_exit_message(int res, const char *prefix_p)
 {
+    mp_hal_stdout_flush();
+
     if (res == 1) {
         std_printf(FSTR("%s exited normally.\r\n\r\n"), prefix_p);
     } else if (res & PYEXEC_FORCED_EXIT) {
@@ -61,6 +63,7 @@ int main()
     std_printf(sys_get_info());
     std_printf(FSTR("\r\n"));
 
+    mp_hal_init();
     stack_top = (intptr_t)&stack_dummy;
     mp_stack_set_limit(40000 * (BYTES_PER_WORD / 4));
     gc_init(heap, heap + sizeof(heap));
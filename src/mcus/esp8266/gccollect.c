@@ -68,6 +68,7 @@ void __assert_func(const char *file,
                    const char *func,
                    const char *expr)
 {
+    mp_hal_stdout_flush();
     std_printf(FSTR("assert:%s:%d:%s: %s\n"), file, line, func, expr);
     nlr_raise(mp_obj_new_exception_msg(&mp_type_AssertionError,
                                        "C-level assert"));
@@ -33,7 +33,8 @@
 #if CONFIG_PUMBAA_CLASS_EXTI == 1
 
 /**
- * Enternal interrupt callback. Called from an interrupt.
+ * Enternal interrupt callback. Called from an interrupt. The Python
+ * callback is scheduled to be called by the VM.
  */
 static void exti_cb_isr(void *self_in)
 {
@@ -42,7 +43,7 @@ static void exti_cb_isr(void *self_in)
     self_p = MP_OBJ_TO_PTR(self_in);
 
     if (self_p->callback != mp_const_none) {
-        mp_call_function_0(self_p->callback);
+        sched_port_schedule_isr(self_p->callback, MP_OBJ_NULL);
     }
 
     if (self_p->chan_type == class_exti_chan_type_event_t) {
@@ -89,9 +89,11 @@ static const mp_rom_map_elem_t module_inet_globals_table[] = {
     /* Module classes. */
 #if CONFIG_PUMBAA_CLASS_HTTP_SERVER == 1
     { MP_ROM_QSTR(MP_QSTR_HttpServer), MP_ROM_PTR(&module_inet_class_http_server) },
+    { MP_ROM_QSTR(MP_QSTR_HttpServerStatic), MP_ROM_PTR(&module_inet_class_http_server_static) },
 #endif
 #if CONFIG_PUMBAA_CLASS_HTTP_SERVER_WEBSOCKET == 1
     { MP_ROM_QSTR(MP_QSTR_HttpServerWebSocket), MP_ROM_PTR(&module_inet_class_http_server_websocket) },
+    { MP_ROM_QSTR(MP_QSTR_HttpServerWebSocketGroup), MP_ROM_PTR(&module_inet_class_http_server_websocket_group) },
 #endif
 
     /* Module functions. */
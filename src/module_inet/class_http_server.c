@@ -29,284 +29,1795 @@
  */
 
 #include "pumbaa.h"
+#include "extmod/uzlib/tinf.h"
 
 extern const mp_obj_type_t module_ssl_class_ssl_context;
 
 #if CONFIG_PUMBAA_CLASS_HTTP_SERVER == 1
 
+/**
+ * The state of given connection thread.
+ */
+static struct class_http_server_connection_state_t *connection_state(
+    struct class_http_server_t *self_p,
+    struct http_server_connection_t *connection_p)
+{
+    return (&self_p->states_p[connection_p - self_p->connections_p]);
+}
+
+/**
+ * Write given buffer to the connection channel.
+ */
+static void response_write_raw(struct class_http_server_connection_t *connection_obj_p,
+                               const void *buf_p,
+                               size_t size)
+{
+    if (chan_write(connection_obj_p->connection_p->chan_p,
+                   buf_p,
+                   size) != size) {
+        mp_raise_OSError(MP_EIO);
+    }
+}
+
+/**
+ * Reason phrase of given response code. Route callbacks may use any
+ * code, not only the ones defined by Simba, so the common codes of
+ * RFC 7231 are mapped.
+ */
+static const char *response_reason(int code)
+{
+    switch (code) {
+
+    case 200:
+        return ("OK");
+
+    case 201:
+        return ("Created");
+
+    case 202:
+        return ("Accepted");
+
+    case 204:
+        return ("No Content");
+
+    case 301:
+        return ("Moved Permanently");
+
+    case 302:
+        return ("Found");
+
+    case 303:
+        return ("See Other");
+
+    case 304:
+        return ("Not Modified");
+
+    case 307:
+        return ("Temporary Redirect");
+
+    case 400:
+        return ("Bad Request");
+
+    case 401:
+        return ("Unauthorized");
+
+    case 403:
+        return ("Forbidden");
+
+    case 404:
+        return ("Not Found");
+
+    case 405:
+        return ("Method Not Allowed");
+
+    case 408:
+        return ("Request Timeout");
+
+    case 409:
+        return ("Conflict");
+
+    case 413:
+        return ("Payload Too Large");
+
+    case 414:
+        return ("URI Too Long");
+
+    case 415:
+        return ("Unsupported Media Type");
+
+    case 431:
+        return ("Request Header Fields Too Large");
+
+    case 500:
+        return ("Internal Server Error");
+
+    case 501:
+        return ("Not Implemented");
+
+    case 503:
+        return ("Service Unavailable");
+
+    default:
+        return ("Unknown");
+    }
+}
+
+/**
+ * Content type string of given content type.
+ */
+static const char *response_content_type(int type)
+{
+    switch (type) {
+
+    case http_server_content_type_text_html_t:
+        return ("text/html");
+
+    case http_server_content_type_text_plain_t:
+        return ("text/plain");
+
+    default:
+        return ("application/octet-stream");
+    }
+}
+
+/**
+ * Write the response header of chunked content.
+ */
+static void response_write_chunked_header(struct class_http_server_connection_t *connection_obj_p,
+                                          struct http_server_response_t *response_p)
+{
+    char header[128];
+    ssize_t size;
+
+    size = std_sprintf(&header[0],
+                       FSTR("HTTP/1.1 %d %s\r\n"
+                            "Content-Type: %s\r\n"
+                            "Transfer-Encoding: chunked\r\n"
+                            "\r\n"),
+                       response_p->code,
+                       response_reason(response_p->code),
+                       response_content_type(response_p->content.type));
+
+    response_write_raw(connection_obj_p, &header[0], size);
+}
+
+/**
+ * Write given chunk. An empty chunk ends the content.
+ */
+static void response_write_chunk(struct class_http_server_connection_t *connection_obj_p,
+                                 const void *buf_p,
+                                 size_t size)
+{
+    char header[12];
+    ssize_t header_size;
+
+    header_size = std_sprintf(&header[0], FSTR("%x\r\n"), size);
+    response_write_raw(connection_obj_p, &header[0], header_size);
+
+    if (size > 0) {
+        response_write_raw(connection_obj_p, buf_p, size);
+    }
+
+    response_write_raw(connection_obj_p, "\r\n", 2);
+}
+
+/**
+ * Write the rest of given file as content with a Content-Length
+ * header. The file is copied to the connection through a fixed
+ * buffer, without creating any Python objects.
+ */
+static void response_write_file(struct class_http_server_connection_t *connection_obj_p,
+                                struct http_server_response_t *response_p,
+                                struct fs_file_t *file_p)
+{
+    struct class_http_server_t *self_p;
+    uint8_t *buf_p;
+    ssize_t position;
+    ssize_t left;
+    ssize_t size;
+
+    self_p = container_of(connection_obj_p->connection_p->self_p,
+                          struct class_http_server_t,
+                          http_server);
+    buf_p = &connection_state(self_p,
+                              connection_obj_p->connection_p)->stream_buf[0];
+
+    /* Size of the rest of the file. */
+    position = fs_tell(file_p);
+
+    if ((position < 0)
+        || (fs_seek(file_p, 0, FS_SEEK_END) != 0)) {
+        mp_raise_OSError(MP_EIO);
+    }
+
+    left = (fs_tell(file_p) - position);
+
+    if (fs_seek(file_p, position, FS_SEEK_SET) != 0) {
+        mp_raise_OSError(MP_EIO);
+    }
+
+    response_p->content.buf_p = NULL;
+    response_p->content.size = left;
+    http_server_response_write(connection_obj_p->connection_p,
+                               connection_obj_p->request_p,
+                               response_p);
+
+    while (left > 0) {
+        size = MIN(left, CONFIG_PUMBAA_CLASS_HTTP_SERVER_STREAM_BUFFER_SIZE);
+        size = fs_read(file_p, buf_p, size);
+
+        if (size <= 0) {
+            mp_raise_OSError(MP_EIO);
+        }
+
+        response_write_raw(connection_obj_p, buf_p, size);
+        left -= size;
+    }
+}
+
+/**
+ * Write the buffers produced by given iterable as content. The
+ * content is chunked if the content length is negative.
+ */
+static void response_write_iterable(struct class_http_server_connection_t *connection_obj_p,
+                                    struct http_server_response_t *response_p,
+                                    mp_obj_t iterable_in,
+                                    mp_int_t content_length)
+{
+    mp_obj_t iter;
+    mp_obj_t item;
+    mp_buffer_info_t buffer_info;
+
+    iter = mp_getiter(iterable_in, NULL);
+
+    if (content_length < 0) {
+        response_write_chunked_header(connection_obj_p, response_p);
+    } else {
+        response_p->content.buf_p = NULL;
+        response_p->content.size = content_length;
+        http_server_response_write(connection_obj_p->connection_p,
+                                   connection_obj_p->request_p,
+                                   response_p);
+    }
+
+    while ((item = mp_iternext(iter)) != MP_OBJ_STOP_ITERATION) {
+        mp_get_buffer_raise(item, &buffer_info, MP_BUFFER_READ);
+
+        /* An empty chunk would end the content. */
+        if (buffer_info.len == 0) {
+            continue;
+        }
+
+        if (content_length < 0) {
+            response_write_chunk(connection_obj_p,
+                                 buffer_info.buf,
+                                 buffer_info.len);
+        } else {
+            response_write_raw(connection_obj_p,
+                               buffer_info.buf,
+                               buffer_info.len);
+        }
+    }
+
+    if (content_length < 0) {
+        response_write_chunk(connection_obj_p, NULL, 0);
+    }
+}
+
+/**
+ * Write given response tuple (content, code, content type, content
+ * length). The content is a buffer, the size of content written by
+ * the callback, an open file, or an iterable of buffers. The content
+ * length is only used for iterables, which are chunked if it is
+ * missing or None.
+ */
 static void response_write(struct class_http_server_connection_t *connection_obj_p,
                            mp_obj_t response_obj)
 {
     mp_obj_tuple_t *tuple_p;
     struct http_server_response_t response;
     mp_buffer_info_t buffer_info;
+    struct fs_file_t *file_p;
+    mp_obj_t content;
+    mp_int_t content_length;
+
+    if (mp_obj_get_type(response_obj) != &mp_type_tuple) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_TypeError,
+                                           "expected tuple"));
+    }
+
+    tuple_p = MP_OBJ_TO_PTR(response_obj);
+
+    if ((tuple_p->len == 0) || (tuple_p->len > 4)) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+                                           "expected tuple of length 1 to 4"));
+    }
+
+    if (tuple_p->len > 1) {
+        response.code = mp_obj_get_int(tuple_p->items[1]);
+    } else {
+        response.code = http_server_response_code_200_ok_t;
+    }
+
+    if (tuple_p->len > 2) {
+        response.content.type = mp_obj_get_int(tuple_p->items[2]);
+    } else {
+        response.content.type = http_server_content_type_text_html_t;
+    }
+
+    if ((tuple_p->len > 3) && (tuple_p->items[3] != mp_const_none)) {
+        content_length = mp_obj_get_int(tuple_p->items[3]);
+    } else {
+        content_length = -1;
+    }
+
+    content = tuple_p->items[0];
+
+    if (mp_obj_get_type(content) == &mp_type_int) {
+        response.content.buf_p = NULL;
+        response.content.size = mp_obj_get_int(content);
+    } else if (mp_get_buffer(content, &buffer_info, MP_BUFFER_READ)) {
+        response.content.buf_p = buffer_info.buf;
+        response.content.size = buffer_info.len;
+    } else {
+        file_p = module_io_file_get(content);
+
+        if (file_p != NULL) {
+            response_write_file(connection_obj_p, &response, file_p);
+        } else {
+            response_write_iterable(connection_obj_p,
+                                    &response,
+                                    content,
+                                    content_length);
+        }
+
+        return;
+    }
+
+    http_server_response_write(connection_obj_p->connection_p,
+                               connection_obj_p->request_p,
+                               &response);
+}
+
+/**
+ * Raise an exception if given connection is closed.
+ */
+static void connection_check_open(struct class_http_server_connection_t *self_p)
+{
+    if (self_p->closed == 1) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
+                                           "connection closed"));
+    }
+}
+
+/**
+ * def response_write(self, response)
+ */
+static mp_obj_t class_http_server_connection_response_write(mp_obj_t self_in,
+                                                            mp_obj_t response_in)
+{
+    struct class_http_server_connection_t *self_p;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+    connection_check_open(self_p);
+    response_write(self_p, response_in);
+
+    return (mp_const_none);
+}
+
+/**
+ * def socket_write(self, buffer)
+ */
+static mp_obj_t class_http_server_connection_socket_write(mp_obj_t self_in,
+                                                          mp_obj_t buffer_in)
+{
+    struct class_http_server_connection_t *self_p;
+    mp_buffer_info_t buffer_info;
+    ssize_t size;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+    connection_check_open(self_p);
+    mp_get_buffer_raise(buffer_in, &buffer_info, MP_BUFFER_READ);
+
+    size = chan_write(self_p->connection_p->chan_p,
+                      buffer_info.buf,
+                      buffer_info.len);
+
+    return (mp_obj_new_int(size));
+}
+
+/**
+ * def socket_read(self, buffer)
+ */
+static mp_obj_t class_http_server_connection_socket_read(mp_obj_t self_in,
+                                                         mp_obj_t size_in)
+{
+    struct class_http_server_connection_t *self_p;
+    vstr_t vstr;
+    size_t size;
+    ssize_t res;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+    connection_check_open(self_p);
+    size = mp_obj_get_int(size_in);
+
+    vstr_init_len(&vstr, size);
+    res = chan_read(self_p->connection_p->chan_p, vstr.buf, size);
+
+    if (res >= 0) {
+        vstr.len = res;
+    } else {
+        vstr.len = 0;
+    }
+
+    /* Keep track of the unread request content. */
+    self_p->content_left -= vstr.len;
+
+    if (self_p->content_left < 0) {
+        self_p->content_left = 0;
+    }
+
+    return (mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr));
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_2(class_http_server_connection_response_write_obj,
+                                 class_http_server_connection_response_write);
+static MP_DEFINE_CONST_FUN_OBJ_2(class_http_server_connection_socket_write_obj,
+                                 class_http_server_connection_socket_write);
+static MP_DEFINE_CONST_FUN_OBJ_2(class_http_server_connection_socket_read_obj,
+                                 class_http_server_connection_socket_read);
+
+static const mp_rom_map_elem_t class_http_server_connection_locals_dict_table[] = {
+    /* Instance methods. */
+    { MP_ROM_QSTR(MP_QSTR_response_write),
+      MP_ROM_PTR(&class_http_server_connection_response_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_socket_write),
+      MP_ROM_PTR(&class_http_server_connection_socket_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_socket_read),
+      MP_ROM_PTR(&class_http_server_connection_socket_read_obj) }
+};
+
+static MP_DEFINE_CONST_DICT(class_http_server_connection_locals_dict, class_http_server_connection_locals_dict_table);
+
+/**
+ * HttpServerConnection class type.
+ */
+const mp_obj_type_t module_inet_class_http_server_connection = {
+    { &mp_type_type },
+    .name = MP_QSTR_HttpServerConnection,
+    .locals_dict = (mp_obj_t)&class_http_server_connection_locals_dict,
+};
+
+/**
+ * Indices of the cached request fields.
+ */
+#define REQUEST_FIELD_PATH                                  0
+#define REQUEST_FIELD_SEC_WEBSOCKET_KEY                     1
+#define REQUEST_FIELD_CONTENT_TYPE                          2
+#define REQUEST_FIELD_AUTHORIZATION                         3
+#define REQUEST_FIELD_EXPECT                                4
+
+/**
+ * Get the value of given string request field, or NULL if missing.
+ */
+static const char *request_field_value(struct http_server_request_t *request_p,
+                                       int index)
+{
+    switch (index) {
+
+    case REQUEST_FIELD_PATH:
+        return (&request_p->path[0]);
+
+    case REQUEST_FIELD_SEC_WEBSOCKET_KEY:
+        if (request_p->headers.sec_websocket_key.present == 1) {
+            return (&request_p->headers.sec_websocket_key.value[0]);
+        }
+        break;
+
+    case REQUEST_FIELD_CONTENT_TYPE:
+        if (request_p->headers.content_type.present == 1) {
+            return (&request_p->headers.content_type.value[0]);
+        }
+        break;
+
+    case REQUEST_FIELD_AUTHORIZATION:
+        if (request_p->headers.authorization.present == 1) {
+            return (&request_p->headers.authorization.value[0]);
+        }
+        break;
+
+    case REQUEST_FIELD_EXPECT:
+        if (request_p->headers.expect.present == 1) {
+            return (&request_p->headers.expect.value[0]);
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return (NULL);
+}
+
+static void request_check_open(struct class_http_server_request_t *self_p)
+{
+    if (self_p->request_p == NULL) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
+                                           "request closed"));
+    }
+}
+
+/**
+ * Get given string request field, creating the string on first
+ * access.
+ */
+static mp_obj_t request_field(struct class_http_server_request_t *self_p,
+                              int index)
+{
+    const char *value_p;
+
+    if (self_p->fields[index] == MP_OBJ_NULL) {
+        request_check_open(self_p);
+        value_p = request_field_value(self_p->request_p, index);
+
+        if (value_p == NULL) {
+            self_p->fields[index] = mp_const_none;
+        } else {
+            self_p->fields[index] = mp_obj_new_str(value_p,
+                                                   strlen(value_p),
+                                                   false);
+        }
+    }
+
+    return (self_p->fields[index]);
+}
+
+static mp_obj_t request_content_length(struct class_http_server_request_t *self_p)
+{
+    request_check_open(self_p);
+
+    if (self_p->request_p->headers.content_length.present == 0) {
+        return (mp_const_none);
+    }
+
+    return (mp_obj_new_int(self_p->request_p->headers.content_length.value));
+}
+
+/**
+ * Header names of the request fields, in lower case.
+ */
+static const struct {
+    const char *name_p;
+    int index;
+} request_headers[] = {
+    { "sec-websocket-key", REQUEST_FIELD_SEC_WEBSOCKET_KEY },
+    { "content-type", REQUEST_FIELD_CONTENT_TYPE },
+    { "authorization", REQUEST_FIELD_AUTHORIZATION },
+    { "expect", REQUEST_FIELD_EXPECT }
+};
+
+/**
+ * Returns true if given header name equals given lower case name,
+ * ignoring case.
+ */
+static int header_name_equal(const char *name_p, const char *lower_p)
+{
+    char c;
+
+    while (*lower_p != '\0') {
+        c = *name_p;
+
+        if ((c >= 'A') && (c <= 'Z')) {
+            c += ('a' - 'A');
+        }
+
+        if (c != *lower_p) {
+            return (0);
+        }
+
+        name_p++;
+        lower_p++;
+    }
+
+    return (*name_p == '\0');
+}
+
+/**
+ * def header(self, name)
+ *
+ * Get the value of given header, or None if missing. Header names
+ * are case insensitive.
+ */
+static mp_obj_t class_http_server_request_header(mp_obj_t self_in,
+                                                 mp_obj_t name_in)
+{
+    struct class_http_server_request_t *self_p;
+    const char *name_p;
+    size_t i;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+    name_p = mp_obj_str_get_str(name_in);
+
+    if (header_name_equal(name_p, "content-length")) {
+        return (request_content_length(self_p));
+    }
+
+    for (i = 0; i < membersof(request_headers); i++) {
+        if (header_name_equal(name_p, request_headers[i].name_p)) {
+            return (request_field(self_p, request_headers[i].index));
+        }
+    }
+
+    return (mp_const_none);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_2(class_http_server_request_header_obj,
+                                 class_http_server_request_header);
+
+/**
+ * Print the request without creating any Python objects.
+ */
+static void class_http_server_request_print(const mp_print_t *print_p,
+                                            mp_obj_t self_in,
+                                            mp_print_kind_t kind)
+{
+    struct class_http_server_request_t *self_p;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+
+    if (self_p->request_p == NULL) {
+        mp_printf(print_p, "HttpServerRequest(closed)");
+    } else {
+        mp_printf(print_p,
+                  "HttpServerRequest(action=%d, path='%s')",
+                  self_p->request_p->action,
+                  &self_p->request_p->path[0]);
+    }
+}
+
+/**
+ * Load given request attribute.
+ */
+static void class_http_server_request_attr(mp_obj_t self_in,
+                                           qstr attr,
+                                           mp_obj_t *dest_p)
+{
+    struct class_http_server_request_t *self_p;
+
+    /* Only loads are supported. */
+    if (dest_p[0] != MP_OBJ_NULL) {
+        return;
+    }
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+
+    switch (attr) {
+
+    case MP_QSTR_action:
+        request_check_open(self_p);
+        dest_p[0] = MP_OBJ_NEW_SMALL_INT(self_p->request_p->action);
+        break;
+
+    case MP_QSTR_path:
+        dest_p[0] = request_field(self_p, REQUEST_FIELD_PATH);
+        break;
+
+    case MP_QSTR_sec_websocket_key:
+        dest_p[0] = request_field(self_p, REQUEST_FIELD_SEC_WEBSOCKET_KEY);
+        break;
+
+    case MP_QSTR_content_type:
+        dest_p[0] = request_field(self_p, REQUEST_FIELD_CONTENT_TYPE);
+        break;
+
+    case MP_QSTR_content_length:
+        dest_p[0] = request_content_length(self_p);
+        break;
+
+    case MP_QSTR_authorization:
+        dest_p[0] = request_field(self_p, REQUEST_FIELD_AUTHORIZATION);
+        break;
+
+    case MP_QSTR_expect:
+        dest_p[0] = request_field(self_p, REQUEST_FIELD_EXPECT);
+        break;
+
+    case MP_QSTR_header:
+        dest_p[0] = MP_OBJ_FROM_PTR(&class_http_server_request_header_obj);
+        dest_p[1] = self_in;
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * HttpServerRequest class type.
+ */
+const mp_obj_type_t module_inet_class_http_server_request = {
+    { &mp_type_type },
+    .name = MP_QSTR_HttpServerRequest,
+    .print = class_http_server_request_print,
+    .attr = class_http_server_request_attr,
+};
+
+/**
+ * Add given route to the route radix tree.
+ */
+static void route_add(struct class_http_server_t *self_p,
+                      struct class_http_server_route_t *route_p)
+{
+    struct class_http_server_route_node_t *node_p;
+    struct class_http_server_route_node_t *middle_p;
+    struct class_http_server_route_node_t **child_pp;
+    struct class_http_server_route_t **route_pp;
+    const char *path_p;
+    size_t length;
+    size_t common;
+
+    path_p = mp_obj_str_get_data(route_p->path, &length);
+    node_p = &self_p->root;
+
+    while (length > 0) {
+        child_pp = &node_p->child_p;
+
+        while ((*child_pp != NULL) && ((*child_pp)->label_p[0] != path_p[0])) {
+            child_pp = &(*child_pp)->sibling_p;
+        }
+
+        /* No child shares a prefix with the path. */
+        if (*child_pp == NULL) {
+            *child_pp = m_new0(struct class_http_server_route_node_t, 1);
+            (*child_pp)->label_p = path_p;
+            (*child_pp)->length = length;
+            node_p = *child_pp;
+            break;
+        }
+
+        common = 1;
+
+        while ((common < length)
+               && (common < (*child_pp)->length)
+               && ((*child_pp)->label_p[common] == path_p[common])) {
+            common++;
+        }
+
+        /* Split the child if the path ends or diverges within its
+           label. */
+        if (common < (*child_pp)->length) {
+            middle_p = m_new0(struct class_http_server_route_node_t, 1);
+            middle_p->label_p = (*child_pp)->label_p;
+            middle_p->length = common;
+            middle_p->child_p = *child_pp;
+            middle_p->sibling_p = (*child_pp)->sibling_p;
+            (*child_pp)->label_p += common;
+            (*child_pp)->length -= common;
+            (*child_pp)->sibling_p = NULL;
+            *child_pp = middle_p;
+        }
+
+        node_p = *child_pp;
+        path_p += common;
+        length -= common;
+    }
+
+    /* Append the route to keep the registration order. */
+    route_pp = &node_p->routes_p;
+
+    while (*route_pp != NULL) {
+        route_pp = &(*route_pp)->next_p;
+    }
+
+    *route_pp = route_p;
+}
+
+/**
+ * Find a route in given node matching given action. Routes for a
+ * specific action are preferred over routes for all actions.
+ */
+static struct class_http_server_route_t *route_node_find(
+    struct class_http_server_route_node_t *node_p,
+    int exact,
+    int action)
+{
+    struct class_http_server_route_t *route_p;
+    struct class_http_server_route_t *any_p;
+
+    any_p = NULL;
+
+    for (route_p = node_p->routes_p; route_p != NULL; route_p = route_p->next_p) {
+        if (route_p->exact != exact) {
+            continue;
+        }
+
+        if (route_p->action == action) {
+            return (route_p);
+        }
+
+        if ((route_p->action == -1) && (any_p == NULL)) {
+            any_p = route_p;
+        }
+    }
+
+    return (any_p);
+}
+
+/**
+ * Find the route of given request by walking the radix tree along the
+ * path. An exact match is preferred over a prefix match, and a longer
+ * prefix over a shorter one. Returns NULL if no route matches.
+ */
+static struct class_http_server_route_t *route_find(
+    struct class_http_server_t *self_p,
+    struct http_server_request_t *request_p)
+{
+    struct class_http_server_route_node_t *node_p;
+    struct class_http_server_route_t *route_p;
+    struct class_http_server_route_t *prefix_p;
+    const char *path_p;
+
+    node_p = &self_p->root;
+    path_p = &request_p->path[0];
+    prefix_p = NULL;
+
+    while (1) {
+        if (*path_p == '\0') {
+            route_p = route_node_find(node_p, 1, request_p->action);
+
+            if (route_p != NULL) {
+                return (route_p);
+            }
+        }
+
+        route_p = route_node_find(node_p, 0, request_p->action);
+
+        if (route_p != NULL) {
+            prefix_p = route_p;
+        }
+
+        if (*path_p == '\0') {
+            break;
+        }
+
+        node_p = node_p->child_p;
+
+        while ((node_p != NULL) && (node_p->label_p[0] != *path_p)) {
+            node_p = node_p->sibling_p;
+        }
+
+        if (node_p == NULL) {
+            break;
+        }
+
+        if (strncmp(node_p->label_p, path_p, node_p->length) != 0) {
+            break;
+        }
+
+        path_p += node_p->length;
+    }
+
+    return (prefix_p);
+}
+
+/**
+ * Create a route from given route tuple (path, callback[, action[,
+ * exact]]) and add it to the route radix tree.
+ */
+static void route_add_tuple(struct class_http_server_t *self_p,
+                            mp_obj_t route_in)
+{
+    struct class_http_server_route_t *route_p;
+    mp_obj_t *items_p;
+    mp_uint_t len;
+
+    mp_obj_get_array(route_in, &len, &items_p);
+
+    if ((len < 2) || (len > 4)) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+                                           "expected route tuple of length 2 to 4"));
+    }
+
+    route_p = m_new_obj(struct class_http_server_route_t);
+    route_p->path = items_p[0];
+    route_p->callback = items_p[1];
+    route_p->action = -1;
+    route_p->exact = 0;
+    route_p->next_p = NULL;
+
+    if (!MP_OBJ_IS_STR_OR_BYTES(route_p->path)) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_TypeError,
+                                           "route path must be a string"));
+    }
+
+    if ((len > 2) && (items_p[2] != mp_const_none)) {
+        route_p->action = mp_obj_get_int(items_p[2]);
+    }
+
+    if (len > 3) {
+        route_p->exact = mp_obj_is_true(items_p[3]);
+    }
+
+    route_add(self_p, route_p);
+}
+
+static void class_http_server_static_print(const mp_print_t *print_p,
+                                           mp_obj_t self_in,
+                                           mp_print_kind_t kind)
+{
+    struct class_http_server_static_t *self_p;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+    mp_printf(print_p,
+              "HttpServerStatic(root='%s')",
+              mp_obj_str_get_str(self_p->root));
+}
+
+/**
+ * def __init__(self, root)
+ *
+ * Create a static files route callback serving files in given root
+ * directory. Files are served with an ETag. The Simba HTTP server
+ * discards the If-None-Match and Accept-Encoding headers of the first
+ * request on a connection, so 304 Not Modified responses and
+ * precompressed files (CONFIG_PUMBAA_CLASS_HTTP_SERVER_STATIC_GZIP)
+ * are only served to later requests on kept-alive connections. That
+ * is, the server must be created with max_requests greater than one.
+ */
+static mp_obj_t class_http_server_static_make_new(const mp_obj_type_t *type_p,
+                                                  mp_uint_t n_args,
+                                                  mp_uint_t n_kw,
+                                                  const mp_obj_t *args_p)
+{
+    struct class_http_server_static_t *self_p;
+
+    mp_arg_check_num(n_args, n_kw, 1, 1, false);
+
+    if (!MP_OBJ_IS_STR(args_p[0])) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_TypeError,
+                                           "root must be a string"));
+    }
+
+    self_p = m_new0(struct class_http_server_static_t, 1);
+    self_p->base.type = &module_inet_class_http_server_static;
+    self_p->root = args_p[0];
+    sem_init(&self_p->sem, 0, 1);
+
+    return (MP_OBJ_FROM_PTR(self_p));
+}
+
+/**
+ * HttpServerStatic class type.
+ */
+const mp_obj_type_t module_inet_class_http_server_static = {
+    { &mp_type_type },
+    .name = MP_QSTR_HttpServerStatic,
+    .print = class_http_server_static_print,
+    .make_new = class_http_server_static_make_new,
+};
+
+/**
+ * Content types of static files by file extension.
+ */
+static const struct {
+    const char *extension_p;
+    const char *content_type_p;
+} static_content_types[] = {
+    { ".html", "text/html" },
+    { ".htm", "text/html" },
+    { ".js", "application/javascript" },
+    { ".css", "text/css" },
+    { ".json", "application/json" },
+    { ".txt", "text/plain" },
+    { ".svg", "image/svg+xml" },
+    { ".png", "image/png" },
+    { ".jpg", "image/jpeg" },
+    { ".ico", "image/x-icon" }
+};
+
+static const char *static_content_type(const char *path_p)
+{
+    const char *extension_p;
+    size_t i;
+
+    extension_p = strrchr(path_p, '.');
+
+    if (extension_p != NULL) {
+        for (i = 0; i < membersof(static_content_types); i++) {
+            if (header_name_equal(extension_p,
+                                  static_content_types[i].extension_p)) {
+                return (static_content_types[i].content_type_p);
+            }
+        }
+    }
+
+    return ("application/octet-stream");
+}
+
+/**
+ * Write given string to the connection channel.
+ */
+static int static_write(struct http_server_connection_t *connection_p,
+                        const void *buf_p,
+                        size_t size)
+{
+    if (chan_write(connection_p->chan_p, buf_p, size) != size) {
+        return (-EIO);
+    }
+
+    return (0);
+}
+
+/**
+ * Open the file of given static route. The precompressed file is
+ * preferred if CONFIG_PUMBAA_CLASS_HTTP_SERVER_STATIC_GZIP is set and
+ * the client accepts gzip. The Accept-Encoding header is unknown for
+ * the first request on a connection, which is therefore never served
+ * the precompressed file.
+ */
+static int static_open(struct fs_file_t *file_p,
+                       struct class_http_server_connection_state_t *state_p,
+                       char *path_p,
+                       int *gzip_p)
+{
+    size_t length;
+
+    *gzip_p = ((CONFIG_PUMBAA_CLASS_HTTP_SERVER_STATIC_GZIP == 1)
+               && (state_p->headers_valid == 1)
+               && (state_p->accept_gzip == 1));
+
+    if (*gzip_p == 1) {
+        length = strlen(path_p);
+        strcpy(&path_p[length], ".gz");
+
+        if (fs_open(file_p, path_p, FS_READ) == 0) {
+            return (0);
+        }
+
+        path_p[length] = '\0';
+        *gzip_p = 0;
+    }
+
+    return (fs_open(file_p, path_p, FS_READ));
+}
+
+/**
+ * Calculate the ETag of given file from its size and the CRC-32 of
+ * its content. The CRC-32 is only calculated if the file is not in
+ * the cache, or if its size has changed, in which case the file is
+ * rewound afterwards. A change that keeps the file size is not
+ * detected. Returns the file size, or negative error code.
+ */
+static int static_etag(struct class_http_server_static_t *static_p,
+                       struct fs_file_t *file_p,
+                       struct class_http_server_connection_state_t *state_p,
+                       const char *path_p,
+                       char *etag_p)
+{
+    struct class_http_server_static_etag_t *entry_p;
+    struct fs_stat_t stat;
+    uint32_t crc;
+    unsigned long size;
+    ssize_t res;
+    int i;
+
+    if (fs_stat(path_p, &stat) != 0) {
+        return (-EIO);
+    }
+
+    sem_take(&static_p->sem, NULL);
+
+    for (i = 0; i < membersof(static_p->etags); i++) {
+        entry_p = &static_p->etags[i];
+
+        if ((entry_p->size == stat.size)
+            && (strcmp(&entry_p->path[0], path_p) == 0)) {
+            crc = entry_p->crc;
+            sem_give(&static_p->sem, 1);
+            std_sprintf(etag_p,
+                        FSTR("\"%lx-%lx\""),
+                        (unsigned long)stat.size,
+                        (unsigned long)crc);
+
+            return (stat.size);
+        }
+    }
+
+    sem_give(&static_p->sem, 1);
+
+    crc = 0xffffffff;
+    size = 0;
+
+    while ((res = fs_read(file_p,
+                          &state_p->stream_buf[0],
+                          sizeof(state_p->stream_buf))) > 0) {
+        crc = uzlib_crc32(&state_p->stream_buf[0], res, crc);
+        size += res;
+    }
+
+    if ((res < 0) || (fs_seek(file_p, 0, FS_SEEK_SET) != 0)) {
+        return (-EIO);
+    }
+
+    crc ^= 0xffffffff;
+
+    /* Replace the oldest entry. */
+    sem_take(&static_p->sem, NULL);
+    entry_p = &static_p->etags[static_p->next];
+    strcpy(&entry_p->path[0], path_p);
+    entry_p->size = size;
+    entry_p->crc = crc;
+    static_p->next = ((static_p->next + 1) % membersof(static_p->etags));
+    sem_give(&static_p->sem, 1);
+
+    std_sprintf(etag_p, FSTR("\"%lx-%lx\""), size, (unsigned long)crc);
+
+    return (size);
+}
+
+/**
+ * Create the path of given file name below given root directory in
+ * given buffer. The query string of the name, if any, is
+ * ignored. Returns zero(0) or negative error code if the name is
+ * empty, too long or outside the root directory.
+ */
+static int static_path(const char *root_p,
+                       const char *name_p,
+                       char *path_p,
+                       size_t size)
+{
+    size_t root_length;
+    size_t name_length;
+
+    root_length = strlen(root_p);
+    name_length = strcspn(name_p, "?");
+
+    /* Leave room for the .gz extension. */
+    if ((name_length == 0) || (root_length + name_length + 5 > size)) {
+        return (-ENOENT);
+    }
+
+    strcpy(path_p, root_p);
+    path_p[root_length] = '/';
+    memcpy(&path_p[root_length + 1], name_p, name_length);
+    path_p[root_length + 1 + name_length] = '\0';
+
+    if (strstr(&path_p[root_length], "..") != NULL) {
+        return (-ENOENT);
+    }
+
+    return (0);
+}
+
+/**
+ * Serve given file below the root directory of given static route.
+ * Returns true if the connection can be kept alive.
+ */
+static int static_serve(struct class_http_server_t *self_p,
+                        struct http_server_connection_t *connection_p,
+                        struct http_server_request_t *request_p,
+                        struct class_http_server_static_t *static_p,
+                        const char *name_p,
+                        long *content_left_p)
+{
+    static const char not_found[] =
+        "HTTP/1.1 404 Not Found\r\n"
+        "Content-Length: 0\r\n"
+        "\r\n";
+    struct class_http_server_connection_state_t *state_p;
+    struct fs_file_t file;
+    const char *root_p;
+    char path[128];
+    char etag[24];
+    int gzip;
+    ssize_t size;
+    ssize_t header_size;
+    int res;
+
+    state_p = connection_state(self_p, connection_p);
+    root_p = mp_obj_str_get_str(static_p->root);
+
+    if (request_p->headers.content_length.present == 1) {
+        *content_left_p = request_p->headers.content_length.value;
+    } else {
+        *content_left_p = 0;
+    }
+
+    while (*name_p == '/') {
+        name_p++;
+    }
+
+    MP_THREAD_GIL_EXIT();
+
+    /* Only files in the root directory tree are served. */
+    if ((request_p->action != http_server_request_action_get_t)
+        || (static_path(root_p, name_p, &path[0], sizeof(path)) != 0)) {
+        res = static_write(connection_p, &not_found[0], sizeof(not_found) - 1);
+        MP_THREAD_GIL_ENTER();
+
+        return (res == 0);
+    }
+
+    if (static_open(&file, state_p, &path[0], &gzip) != 0) {
+        res = static_write(connection_p, &not_found[0], sizeof(not_found) - 1);
+        MP_THREAD_GIL_ENTER();
+
+        return (res == 0);
+    }
+
+    size = static_etag(static_p, &file, state_p, &path[0], &etag[0]);
+
+    if (size < 0) {
+        res = -EIO;
+    } else if ((state_p->headers_valid == 1)
+               && (strstr(&state_p->if_none_match[0], &etag[0]) != NULL)) {
+        /* The client has the current version of the file. */
+        header_size = std_sprintf((char *)&state_p->stream_buf[0],
+                                  FSTR("HTTP/1.1 304 Not Modified\r\n"
+                                       "ETag: %s\r\n"
+                                       "\r\n"),
+                                  &etag[0]);
+        res = static_write(connection_p, &state_p->stream_buf[0], header_size);
+    } else {
+        /* Remove the .gz extension to get the content type. */
+        if (gzip == 1) {
+            path[strlen(&path[0]) - 3] = '\0';
+        }
+
+        header_size = std_sprintf((char *)&state_p->stream_buf[0],
+                                  FSTR("HTTP/1.1 200 OK\r\n"
+                                       "Content-Type: %s\r\n"
+                                       "Content-Length: %lu\r\n"
+                                       "%s"
+                                       "ETag: %s\r\n"
+                                       "\r\n"),
+                                  static_content_type(&path[0]),
+                                  (unsigned long)size,
+                                  (gzip == 1
+                                   ? "Content-Encoding: gzip\r\n"
+                                   "Vary: Accept-Encoding\r\n"
+                                   : ""),
+                                  &etag[0]);
+        res = static_write(connection_p, &state_p->stream_buf[0], header_size);
+
+        while ((res == 0)
+               && ((size = fs_read(&file,
+                                   &state_p->stream_buf[0],
+                                   sizeof(state_p->stream_buf))) > 0)) {
+            res = static_write(connection_p, &state_p->stream_buf[0], size);
+        }
+
+        if (size < 0) {
+            res = -EIO;
+        }
+    }
+
+    fs_close(&file);
+    MP_THREAD_GIL_ENTER();
+
+    return (res == 0);
+}
+
+/**
+ * Call the route callback of given request. Returns true if the
+ * connection can be kept alive, and the size of the request content
+ * not read by the callback.
+ */
+static int request_dispatch(struct class_http_server_t *self_p,
+                            struct http_server_connection_t *connection_p,
+                            struct http_server_request_t *request_p,
+                            long *content_left_p)
+{
+    struct class_http_server_connection_t *connection_obj_p;
+    nlr_buf_t nlr;
+    struct class_http_server_route_t *route_p;
+    mp_obj_t route_callback;
+    struct class_http_server_request_t *request_obj_p;
+    mp_obj_t response_obj;
+    int keep_alive;
+    size_t prefix_length;
+
+    route_p = route_find(self_p, request_p);
+
+    if (route_p == NULL) {
+        route_callback = self_p->no_route;
+        prefix_length = 0;
+    } else {
+        route_callback = route_p->callback;
+        mp_obj_str_get_data(route_p->path, &prefix_length);
+    }
+
+    /* Static files are served without calling into Python. */
+    if (MP_OBJ_IS_TYPE(route_callback, &module_inet_class_http_server_static)) {
+        return (static_serve(self_p,
+                             connection_p,
+                             request_p,
+                             MP_OBJ_TO_PTR(route_callback),
+                             &request_p->path[prefix_length],
+                             content_left_p));
+    }
+
+    /* Create the request object. Fields are created on access. */
+    request_obj_p = m_new0(struct class_http_server_request_t, 1);
+    request_obj_p->base.type = &module_inet_class_http_server_request;
+    request_obj_p->request_p = request_p;
+
+    /* Create the connection object. */
+    connection_obj_p = m_new_obj(struct class_http_server_connection_t);
+    connection_obj_p->base.type = &module_inet_class_http_server_connection;
+    connection_obj_p->connection_p = connection_p;
+    connection_obj_p->request_p = request_p;
+    sem_init(&connection_obj_p->write_sem, 0, 1);
+    connection_obj_p->closed = 0;
+
+    if (request_p->headers.content_length.present == 1) {
+        connection_obj_p->content_left = request_p->headers.content_length.value;
+    } else {
+        connection_obj_p->content_left = 0;
+    }
+
+    /* The connection is upgraded to a WebSocket. */
+    keep_alive = (request_p->headers.sec_websocket_key.present == 0);
+
+    if (nlr_push(&nlr) == 0) {
+        response_obj = mp_call_function_2(route_callback,
+                                          MP_OBJ_FROM_PTR(connection_obj_p),
+                                          MP_OBJ_FROM_PTR(request_obj_p));
+
+        if (response_obj != mp_const_none) {
+            response_write(connection_obj_p, response_obj);
+        }
+
+        nlr_pop();
+    } else {
+        mp_obj_print_exception(&mp_plat_print, MP_OBJ_FROM_PTR(nlr.ret_val));
+
+        /* The response may be incomplete. */
+        keep_alive = 0;
+    }
+
+    /* The Simba request and connection are reused for the next
+       request. */
+    request_obj_p->request_p = NULL;
+    sem_take(&connection_obj_p->write_sem, NULL);
+    connection_obj_p->closed = 1;
+    sem_give(&connection_obj_p->write_sem, 1);
+    *content_left_p = connection_obj_p->content_left;
+
+    return (keep_alive);
+}
+
+/**
+ * Returns the number of bytes available to read from given
+ * connection. The SSL channel of a connection wrapped in SSL is never
+ * woken up by a poll, so the socket it wraps is polled instead, and
+ * data is available if decrypted data is buffered in the SSL layer or
+ * if a record is pending on the socket.
+ */
+static ssize_t connection_size(struct http_server_connection_t *connection_p)
+{
+    ssize_t size;
+
+    size = chan_size(&connection_p->socket);
+
+#if CONFIG_PUMBAA_MODULE_SSL == 1
+    if (connection_p->chan_p != &connection_p->socket) {
+        if (size < 0) {
+            size = 0;
+        }
+
+        size += ssl_socket_size(connection_p->chan_p);
+    }
+#endif
+
+    return (size);
+}
+
+/**
+ * Read a line from given channel into given buffer, without the line
+ * ending. Too long lines are truncated, but the length of the whole
+ * line is returned, so the line was truncated if the returned length
+ * is at least given size. Returns -1 if the connection was closed.
+ */
+static ssize_t request_read_line(void *chan_p, char *buf_p, size_t size)
+{
+    size_t length;
+    char c;
+
+    length = 0;
+
+    while (1) {
+        if (chan_read(chan_p, &c, 1) != 1) {
+            return (-1);
+        }
+
+        if (c == '\n') {
+            break;
+        }
+
+        if (c != '\r') {
+            if (length < size - 1) {
+                buf_p[length] = c;
+            }
+
+            length++;
+        }
+    }
+
+    buf_p[MIN(length, size - 1)] = '\0';
+
+    return (length);
+}
+
+/**
+ * Copy given header value into given field value buffer.
+ */
+static void request_header_copy(char *dst_p, size_t size, const char *src_p)
+{
+    strncpy(dst_p, src_p, size - 1);
+    dst_p[size - 1] = '\0';
+}
+
+/**
+ * Parse given header line into given request. Truncated lines are
+ * only accepted for fields that are ignored. Returns zero(0) on
+ * success, or negative error code if a used field was truncated.
+ */
+static int request_parse_header(struct http_server_request_t *request_p,
+                                struct class_http_server_connection_state_t *state_p,
+                                char *line_p,
+                                int truncated,
+                                int *keep_alive_p)
+{
+    char *value_p;
+    long content_length;
+
+    value_p = strchr(line_p, ':');
+
+    if (value_p == NULL) {
+        return (0);
+    }
+
+    *value_p++ = '\0';
+
+    while (*value_p == ' ') {
+        value_p++;
+    }
+
+    if (header_name_equal(line_p, "content-length")) {
+        content_length = 0;
+
+        while ((*value_p >= '0') && (*value_p <= '9')) {
+            content_length = (10 * content_length + (*value_p - '0'));
+            value_p++;
+        }
+
+        request_p->headers.content_length.present = 1;
+        request_p->headers.content_length.value = content_length;
+    } else if (header_name_equal(line_p, "content-type")) {
+        request_p->headers.content_type.present = 1;
+        request_header_copy(&request_p->headers.content_type.value[0],
+                            sizeof(request_p->headers.content_type.value),
+                            value_p);
+    } else if (header_name_equal(line_p, "authorization")) {
+        request_p->headers.authorization.present = 1;
+        request_header_copy(&request_p->headers.authorization.value[0],
+                            sizeof(request_p->headers.authorization.value),
+                            value_p);
+    } else if (header_name_equal(line_p, "expect")) {
+        request_p->headers.expect.present = 1;
+        request_header_copy(&request_p->headers.expect.value[0],
+                            sizeof(request_p->headers.expect.value),
+                            value_p);
+    } else if (header_name_equal(line_p, "sec-websocket-key")) {
+        request_p->headers.sec_websocket_key.present = 1;
+        request_header_copy(&request_p->headers.sec_websocket_key.value[0],
+                            sizeof(request_p->headers.sec_websocket_key.value),
+                            value_p);
+    } else if (header_name_equal(line_p, "accept-encoding")) {
+        state_p->accept_gzip = (strstr(value_p, "gzip") != NULL);
+    } else if (header_name_equal(line_p, "if-none-match")) {
+        request_header_copy(&state_p->if_none_match[0],
+                            sizeof(state_p->if_none_match),
+                            value_p);
+    } else if (header_name_equal(line_p, "connection")) {
+        if (header_name_equal(value_p, "close")) {
+            *keep_alive_p = 0;
+        } else if (header_name_equal(value_p, "keep-alive")) {
+            *keep_alive_p = 1;
+        }
+    } else {
+        return (0);
+    }
+
+    return (truncated == 1 ? -EPROTO : 0);
+}
+
+/**
+ * Respond with given error status and close the connection.
+ */
+static void response_write_error(struct http_server_connection_t *connection_p,
+                                 const char *status_p)
+{
+    static const char prefix[] = "HTTP/1.1 ";
+    static const char suffix[] =
+        "\r\n"
+        "Content-Length: 0\r\n"
+        "Connection: close\r\n"
+        "\r\n";
+
+    chan_write(connection_p->chan_p, &prefix[0], sizeof(prefix) - 1);
+    chan_write(connection_p->chan_p, status_p, strlen(status_p));
+    chan_write(connection_p->chan_p, &suffix[0], sizeof(suffix) - 1);
+}
+
+/**
+ * Wait for the next request on given kept alive connection, and
+ * parse its header into given request. The unread content of the
+ * previous request is discarded first. Returns zero on success, or
+ * negative error code if the connection shall be closed. Malformed,
+ * too long and unsupported requests are answered with an error
+ * status before the connection is closed.
+ */
+static int request_read_next(struct class_http_server_t *self_p,
+                             struct http_server_connection_t *connection_p,
+                             struct http_server_request_t *request_p,
+                             long content_left,
+                             int *keep_alive_p)
+{
+    struct class_http_server_connection_state_t *state_p;
+    struct chan_list_t list;
+    void *workspace[1];
+    void *chan_p;
+    void *woken_p;
+    char line[128];
+    char *path_p;
+    char *version_p;
+    ssize_t size;
+
+    state_p = connection_state(self_p, connection_p);
+    chan_p = connection_p->chan_p;
+
+    /* Discard the request content not read by the callback. */
+    while (content_left > 0) {
+        size = MIN(content_left,
+                   CONFIG_PUMBAA_CLASS_HTTP_SERVER_STREAM_BUFFER_SIZE);
+
+        if (chan_read(chan_p, &state_p->stream_buf[0], size) != size) {
+            return (-EIO);
+        }
 
-    if (mp_obj_get_type(response_obj) != &mp_type_tuple) {
-        nlr_raise(mp_obj_new_exception_msg(&mp_type_TypeError,
-                                           "expected tuple"));
+        content_left -= size;
     }
 
-    tuple_p = MP_OBJ_TO_PTR(response_obj);
+    /* Wait for the next request. Pipelined requests are already
+       buffered in the channel. */
+    if (connection_size(connection_p) == 0) {
+        chan_list_init(&list, &workspace[0], sizeof(workspace));
+        chan_list_add(&list, &connection_p->socket);
+        woken_p = chan_list_poll(&list, &self_p->idle_timeout);
+        chan_list_remove(&list, &connection_p->socket);
 
-    if (tuple_p->len == 0) {
-        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
-                                           "expected tuple of length >0"));
+        if (woken_p == NULL) {
+            return (-ETIMEDOUT);
+        }
     }
 
-    if (mp_obj_get_type(tuple_p->items[0]) == &mp_type_int) {
-        response.content.buf_p = NULL;
-        response.content.size = mp_obj_get_int(tuple_p->items[0]);
-    } else {
-        mp_get_buffer_raise(tuple_p->items[0],
-                            &buffer_info,
-                            MP_BUFFER_READ);
-        response.content.buf_p = buffer_info.buf;
-        response.content.size = buffer_info.len;
+    /* The request line. */
+    size = request_read_line(chan_p, &line[0], sizeof(line));
+
+    if (size <= 0) {
+        return (-EIO);
     }
 
-    if (tuple_p->len > 1) {
-        response.code = mp_obj_get_int(tuple_p->items[1]);
-    } else {
-        response.code = http_server_response_code_200_ok_t;
+    if (size >= (ssize_t)sizeof(line)) {
+        response_write_error(connection_p, "414 URI Too Long");
+
+        return (-EPROTO);
     }
 
-    if (tuple_p->len > 2) {
-        response.content.type = mp_obj_get_int(tuple_p->items[2]);
+    path_p = strchr(&line[0], ' ');
+
+    if (path_p == NULL) {
+        response_write_error(connection_p, "400 Bad Request");
+
+        return (-EPROTO);
+    }
+
+    *path_p++ = '\0';
+    version_p = strchr(path_p, ' ');
+
+    if (version_p == NULL) {
+        response_write_error(connection_p, "400 Bad Request");
+
+        return (-EPROTO);
+    }
+
+    *version_p++ = '\0';
+    memset(request_p, 0, sizeof(*request_p));
+    state_p->headers_valid = 1;
+    state_p->accept_gzip = 0;
+    state_p->if_none_match[0] = '\0';
+
+    if (strcmp(&line[0], "GET") == 0) {
+        request_p->action = http_server_request_action_get_t;
+    } else if (strcmp(&line[0], "POST") == 0) {
+        request_p->action = http_server_request_action_post_t;
     } else {
-        response.content.type = http_server_content_type_text_html_t;
+        response_write_error(connection_p, "501 Not Implemented");
+
+        return (-EPROTO);
     }
 
-    http_server_response_write(connection_obj_p->connection_p,
-                               connection_obj_p->request_p,
-                               &response);
-}
+    if (strlen(path_p) >= sizeof(request_p->path)) {
+        response_write_error(connection_p, "414 URI Too Long");
 
-/**
- * def response_write(self, response)
- */
-static mp_obj_t class_http_server_connection_response_write(mp_obj_t self_in,
-                                                            mp_obj_t response_in)
-{
-    struct class_http_server_connection_t *self_p;
+        return (-EPROTO);
+    }
 
-    self_p = MP_OBJ_TO_PTR(self_in);
-    response_write(self_p, response_in);
+    strcpy(&request_p->path[0], path_p);
 
-    return (mp_const_none);
-}
+    /* HTTP/1.0 connections are only kept alive on request. */
+    *keep_alive_p = (strcmp(version_p, "HTTP/1.0") != 0);
 
-/**
- * def socket_write(self, buffer)
- */
-static mp_obj_t class_http_server_connection_socket_write(mp_obj_t self_in,
-                                                          mp_obj_t buffer_in)
-{
-    struct class_http_server_connection_t *self_p;
-    mp_buffer_info_t buffer_info;
-    ssize_t size;
+    /* The header fields. */
+    while (1) {
+        size = request_read_line(chan_p, &line[0], sizeof(line));
 
-    self_p = MP_OBJ_TO_PTR(self_in);
-    mp_get_buffer_raise(buffer_in, &buffer_info, MP_BUFFER_READ);
+        if (size < 0) {
+            return (-EIO);
+        }
 
-    size = chan_write(self_p->connection_p->chan_p,
-                      buffer_info.buf,
-                      buffer_info.len);
+        if (size == 0) {
+            break;
+        }
 
-    return (mp_obj_new_int(size));
+        if (request_parse_header(request_p,
+                                 state_p,
+                                 &line[0],
+                                 size >= (ssize_t)sizeof(line),
+                                 keep_alive_p) != 0) {
+            response_write_error(connection_p,
+                                 "431 Request Header Fields Too Large");
+
+            return (-EPROTO);
+        }
+    }
+
+    return (0);
 }
 
 /**
- * def socket_read(self, buffer)
+ * Wait for a free worker. Returns zero once a worker is taken, or -1
+ * if the queue is full.
  */
-static mp_obj_t class_http_server_connection_socket_read(mp_obj_t self_in,
-                                                         mp_obj_t size_in)
+static int worker_take(struct class_http_server_t *self_p)
 {
-    struct class_http_server_connection_t *self_p;
-    vstr_t vstr;
-    size_t size;
-    ssize_t res;
+    int queue_depth;
 
-    self_p = MP_OBJ_TO_PTR(self_in);
-    size = mp_obj_get_int(size_in);
+    sys_lock();
 
-    vstr_init_len(&vstr, size);
-    res = chan_read(self_p->connection_p->chan_p, vstr.buf, size);
+    if ((self_p->queue_size >= 0)
+        && (self_p->pending >= self_p->number_of_workers + self_p->queue_size)) {
+        self_p->statistics.rejected++;
+        sys_unlock();
 
-    if (res >= 0) {
-        vstr.len = res;
-    } else {
-        vstr.len = 0;
+        return (-1);
     }
 
-    return (mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr));
-}
+    self_p->pending++;
+    queue_depth = (self_p->pending - self_p->number_of_workers);
 
-static MP_DEFINE_CONST_FUN_OBJ_2(class_http_server_connection_response_write_obj,
-                                 class_http_server_connection_response_write);
-static MP_DEFINE_CONST_FUN_OBJ_2(class_http_server_connection_socket_write_obj,
-                                 class_http_server_connection_socket_write);
-static MP_DEFINE_CONST_FUN_OBJ_2(class_http_server_connection_socket_read_obj,
-                                 class_http_server_connection_socket_read);
+    if (queue_depth > self_p->statistics.queue_depth_max) {
+        self_p->statistics.queue_depth_max = queue_depth;
+    }
 
-static const mp_rom_map_elem_t class_http_server_connection_locals_dict_table[] = {
-    /* Instance methods. */
-    { MP_ROM_QSTR(MP_QSTR_response_write),
-      MP_ROM_PTR(&class_http_server_connection_response_write_obj) },
-    { MP_ROM_QSTR(MP_QSTR_socket_write),
-      MP_ROM_PTR(&class_http_server_connection_socket_write_obj) },
-    { MP_ROM_QSTR(MP_QSTR_socket_read),
-      MP_ROM_PTR(&class_http_server_connection_socket_read_obj) }
-};
+    sys_unlock();
 
-static MP_DEFINE_CONST_DICT(class_http_server_connection_locals_dict, class_http_server_connection_locals_dict_table);
+    sem_take(&self_p->workers_sem, NULL);
+
+    return (0);
+}
 
 /**
- * HttpServerConnection class type.
+ * Release given worker and record the latency of the handled
+ * request.
  */
-const mp_obj_type_t module_inet_class_http_server_connection = {
-    { &mp_type_type },
-    .name = MP_QSTR_HttpServerConnection,
-    .locals_dict = (mp_obj_t)&class_http_server_connection_locals_dict,
-};
+static void worker_give(struct class_http_server_t *self_p,
+                        struct time_t *start_p)
+{
+    struct time_t now;
+    unsigned long latency;
+
+    time_get(&now);
+    latency = ((now.seconds - start_p->seconds) * 1000000L
+               + (now.nanoseconds - start_p->nanoseconds) / 1000L);
+
+    sem_give(&self_p->workers_sem, 1);
+
+    sys_lock();
+    self_p->pending--;
+    self_p->statistics.requests++;
+    self_p->statistics.latency_total += latency;
+
+    if (latency > self_p->statistics.latency_max) {
+        self_p->statistics.latency_max = latency;
+    }
+
+    sys_unlock();
+}
 
 /**
- * Request named tuple fields.
+ * Respond with 503 Service Unavailable.
  */
-static const qstr request_fields[] = {
-    MP_QSTR_action,
-    MP_QSTR_path,
-    MP_QSTR_sec_websocket_key,
-    MP_QSTR_content_type,
-    MP_QSTR_content_length,
-    MP_QSTR_authorization,
-    MP_QSTR_expect
-};
+static void response_write_service_unavailable(struct http_server_connection_t *connection_p)
+{
+    static const char response[] =
+        "HTTP/1.1 503 Service Unavailable\r\n"
+        "Content-Length: 0\r\n"
+        "\r\n";
+
+    chan_write(connection_p->chan_p, &response[0], sizeof(response) - 1);
+}
 
 /**
- * All routes are handled by this function.
+ * All routes are handled by this function. The Simba HTTP server
+ * closes the connection when this function returns, so kept alive
+ * connections are served in a loop until the client closes the
+ * connection, the connection has been idle for too long, or the
+ * request limit is reached.
  */
 static int on_no_route(struct http_server_connection_t *connection_p,
                        struct http_server_request_t *request_p)
 {
     struct class_http_server_t *self_p;
-    struct class_http_server_connection_t *connection_obj_p;
-    nlr_buf_t nlr;
-    mp_obj_t route_callback;
-    mp_obj_t request_obj;
-    mp_obj_t response_obj;
-    mp_obj_t *routes_p;
-    mp_obj_tuple_t *tuple_p;
-    mp_obj_t tuple[7];
-    mp_buffer_info_t buffer_info;
-    mp_uint_t len;
-    mp_uint_t i;
-    vstr_t vstr;
-    size_t size;
+    int number_of_requests;
+    int keep_alive;
+    int client_keep_alive;
+    long content_left;
+    struct time_t start;
 
     self_p = container_of(connection_p->self_p,
                           struct class_http_server_t,
                           http_server);
+    number_of_requests = 0;
+    client_keep_alive = 1;
+    connection_state(self_p, connection_p)->headers_valid = 0;
 
-    MP_THREAD_GIL_ENTER();
-
-    /* Create the request object (a named tuple). */
-    tuple[0] = mp_obj_new_int(request_p->action);
-
-    size = strlen(&request_p->path[0]);
-    vstr_init_fixed_buf(&vstr, size + 1, &request_p->path[0]);
-    vstr.len = size;
-    tuple[1] = mp_obj_new_str_from_vstr(&mp_type_str, &vstr);
-
-    if (request_p->headers.sec_websocket_key.present == 1) {
-        size = strlen(&request_p->headers.sec_websocket_key.value[0]);
-        vstr_init_fixed_buf(&vstr, size + 1, &request_p->headers.sec_websocket_key.value[0]);
-        vstr.len = size;
-        tuple[2] = mp_obj_new_str_from_vstr(&mp_type_str, &vstr);
-    } else {
-        tuple[2] = mp_const_none;
-    }
-
-    if (request_p->headers.content_type.present == 1) {
-        size = strlen(&request_p->headers.content_type.value[0]);
-        vstr_init_fixed_buf(&vstr, size + 1, &request_p->headers.content_type.value[0]);
-        vstr.len = size;
-        tuple[3] = mp_obj_new_str_from_vstr(&mp_type_str, &vstr);
-    } else {
-        tuple[3] = mp_const_none;
-    }
-
-    if (request_p->headers.content_length.present == 1) {
-        tuple[4] = mp_obj_new_int(request_p->headers.content_length.value);
-    } else {
-        tuple[4] = mp_const_none;
-    }
-
-    if (request_p->headers.authorization.present == 1) {
-        size = strlen(&request_p->headers.authorization.value[0]);
-        vstr_init_fixed_buf(&vstr, size + 1, &request_p->headers.authorization.value[0]);
-        vstr.len = size;
-        tuple[5] = mp_obj_new_str_from_vstr(&mp_type_str, &vstr);
-    } else {
-        tuple[5] = mp_const_none;
-    }
+    while (1) {
+        if (worker_take(self_p) != 0) {
+            response_write_service_unavailable(connection_p);
+            break;
+        }
 
-    if (request_p->headers.expect.present == 1) {
-        size = strlen(&request_p->headers.expect.value[0]);
-        vstr_init_fixed_buf(&vstr, size + 1, &request_p->headers.expect.value[0]);
-        vstr.len = size;
-        tuple[6] = mp_obj_new_str_from_vstr(&mp_type_str, &vstr);
-    } else {
-        tuple[6] = mp_const_none;
-    }
+        time_get(&start);
 
-    request_obj = mp_obj_new_attrtuple(&request_fields[0],
-                                       membersof(tuple),
-                                       tuple);
+        MP_THREAD_GIL_ENTER();
+        keep_alive = request_dispatch(self_p,
+                                      connection_p,
+                                      request_p,
+                                      &content_left);
+        MP_THREAD_GIL_EXIT();
 
-    /* Create the connection object. */
-    connection_obj_p = m_new_obj(struct class_http_server_connection_t);
-    connection_obj_p->base.type = &module_inet_class_http_server_connection;
-    connection_obj_p->connection_p = connection_p;
-    connection_obj_p->request_p = request_p;
+        worker_give(self_p, &start);
 
-    /* Iterate over registered routes. */
-    mp_obj_list_get(self_p->routes, &len, &routes_p);
-    route_callback = mp_const_none;
+        number_of_requests++;
 
-    for (i = 0; i < len; i++) {
-        tuple_p = MP_OBJ_TO_PTR(routes_p[i]);
-        mp_get_buffer_raise(tuple_p->items[0],
-                            &buffer_info,
-                            MP_BUFFER_READ);
-
-        if (strncmp(buffer_info.buf,
-                    &request_p->path[0],
-                    buffer_info.len) == 0) {
-            route_callback = tuple_p->items[1];
+        if ((keep_alive == 0)
+            || (client_keep_alive == 0)
+            || (number_of_requests >= self_p->max_requests)) {
             break;
         }
-    }
-
-    if (route_callback == mp_const_none) {
-        route_callback = self_p->no_route;
-    }
-
-    if (nlr_push(&nlr) == 0) {
-        response_obj = mp_call_function_2(route_callback,
-                                          MP_OBJ_FROM_PTR(connection_obj_p),
-                                          request_obj);
 
-        if (response_obj != mp_const_none) {
-            response_write(connection_obj_p, response_obj);
+        if (request_read_next(self_p,
+                              connection_p,
+                              request_p,
+                              content_left,
+                              &client_keep_alive) != 0) {
+            break;
         }
-
-        nlr_pop();
-    } else {
-        mp_obj_print_exception(&mp_plat_print, MP_OBJ_FROM_PTR(nlr.ret_val));
     }
 
-    MP_THREAD_GIL_EXIT();
-
     return (0);
 }
 
@@ -323,6 +1834,22 @@ static void class_http_server_print(const mp_print_t *print_p,
     mp_printf(print_p, "<0x%p>", self_p);
 }
 
+/**
+ * Free the stacks of the listener thread and given number of
+ * connection threads.
+ */
+static void connections_stack_free(struct class_http_server_t *self_p,
+                                   int number_of_connections)
+{
+    int i;
+
+    for (i = 0; i < number_of_connections; i++) {
+        thrd_stack_free(self_p->connections_p[i].thrd.stack.buf_p);
+    }
+
+    thrd_stack_free(self_p->listener.thrd.stack.buf_p);
+}
+
 /**
  * Create a new HttpServer object associated with the id. If
  * additional arguments are given, they are used to initialise the
@@ -341,13 +1868,22 @@ static mp_obj_t class_http_server_make_new(const mp_obj_type_t *type_p,
         { MP_QSTR_routes, MP_ARG_REQUIRED | MP_ARG_OBJ },
         { MP_QSTR_no_route, MP_ARG_REQUIRED | MP_ARG_OBJ },
         { MP_QSTR_clients_max, MP_ARG_INT, { .u_int = 1 } },
+        { MP_QSTR_max_requests, MP_ARG_INT, { .u_int = 1 } },
+        { MP_QSTR_idle_timeout, MP_ARG_OBJ, { .u_rom_obj = MP_ROM_PTR(&mp_const_none_obj) } },
+        { MP_QSTR_workers, MP_ARG_INT, { .u_int = 1 } },
+        { MP_QSTR_queue, MP_ARG_OBJ, { .u_rom_obj = MP_ROM_PTR(&mp_const_none_obj) } },
     };
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
     const char *address_p;
     int port;
     void *stack_p;
+    mp_obj_t *routes_p;
+    mp_uint_t len;
+    mp_uint_t i;
+    float f_timeout;
+    int number_of_connections;
 
-    mp_arg_check_num(n_args, n_kw, 0, 5, true);
+    mp_arg_check_num(n_args, n_kw, 0, 9, true);
 
     /* Parse args. */
     mp_map_init_fixed_table(&kwargs, n_kw, args_p + n_args);
@@ -363,8 +1899,61 @@ static mp_obj_t class_http_server_make_new(const mp_obj_type_t *type_p,
     port = args[1].u_int;
 
     /* Initiate a new HttpServer object. */
-    self_p = m_new_obj(struct class_http_server_t);
+    self_p = m_new0(struct class_http_server_t, 1);
     self_p->base.type = &module_inet_class_http_server;
+    self_p->routes = args[2].u_obj;
+    self_p->no_route = args[3].u_obj;
+
+    /* Keep alive configuration. */
+    if (args[5].u_int < 1) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+                                           "max_requests must be at least 1"));
+    }
+
+    self_p->max_requests = args[5].u_int;
+
+    if (args[6].u_obj == mp_const_none) {
+        f_timeout = CONFIG_PUMBAA_CLASS_HTTP_SERVER_IDLE_TIMEOUT;
+    } else {
+        f_timeout = mp_obj_get_float(args[6].u_obj);
+
+        if (f_timeout < 0) {
+            nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+                                               "timeout value out of range"));
+        }
+    }
+
+    self_p->idle_timeout.seconds = (long)f_timeout;
+    self_p->idle_timeout.nanoseconds =
+        (f_timeout - self_p->idle_timeout.seconds) * 1000000000L;
+
+    /* Worker pool configuration. */
+    if (args[7].u_int < 1) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+                                           "workers must be at least 1"));
+    }
+
+    self_p->number_of_workers = args[7].u_int;
+
+    if (args[8].u_obj == mp_const_none) {
+        self_p->queue_size = -1;
+    } else {
+        self_p->queue_size = mp_obj_get_int(args[8].u_obj);
+
+        if (self_p->queue_size < 0) {
+            nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+                                               "queue must be at least 0"));
+        }
+    }
+
+    sem_init(&self_p->workers_sem, 0, self_p->number_of_workers);
+
+    /* Build the route radix tree. */
+    mp_obj_get_array(self_p->routes, &len, &routes_p);
+
+    for (i = 0; i < len; i++) {
+        route_add_tuple(self_p, routes_p[i]);
+    }
 
     stack_p = thrd_stack_alloc(1024);
 
@@ -379,32 +1968,45 @@ static mp_obj_t class_http_server_make_new(const mp_obj_type_t *type_p,
     self_p->listener.thrd.stack.buf_p = stack_p;
     self_p->listener.thrd.stack.size = 1024;
 
-    stack_p = thrd_stack_alloc(4096);
+    /* Preallocate the connection threads and their stream
+       buffers. */
+    number_of_connections = self_p->number_of_workers;
 
-    if (stack_p == NULL) {
-        thrd_stack_free(self_p->listener.thrd.stack.buf_p);
-        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
-                                           "out of thread memory"));
+    if (self_p->queue_size >= 0) {
+        number_of_connections += (self_p->queue_size + 1);
     }
 
-    self_p->connections[0].thrd.name_p = "http_conn_0";
-    self_p->connections[0].thrd.stack.buf_p = stack_p;
-    self_p->connections[0].thrd.stack.size = 4096;
+    self_p->connections_p = m_new0(struct http_server_connection_t,
+                                   number_of_connections + 1);
+    self_p->states_p = m_new0(struct class_http_server_connection_state_t,
+                              number_of_connections);
+
+    for (i = 0; i < number_of_connections; i++) {
+        stack_p = thrd_stack_alloc(4096);
+
+        if (stack_p == NULL) {
+            connections_stack_free(self_p, i);
+            nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
+                                               "out of thread memory"));
+        }
+
+        self_p->connections_p[i].thrd.name_p = "http_conn";
+        self_p->connections_p[i].thrd.stack.buf_p = stack_p;
+        self_p->connections_p[i].thrd.stack.size = 4096;
+    }
 
-    self_p->connections[1].thrd.name_p = NULL;
+    self_p->connections_p[i].thrd.name_p = NULL;
+    self_p->number_of_connections = number_of_connections;
 
     self_p->empty_routes[0].path_p = NULL;
-    self_p->routes = args[2].u_obj;
-    self_p->no_route = args[3].u_obj;
 
     if (http_server_init(&self_p->http_server,
                          &self_p->listener,
-                         &self_p->connections[0],
+                         self_p->connections_p,
                          NULL,
                          &self_p->empty_routes[0],
                          on_no_route) != 0) {
-        thrd_stack_free(stack_p);
-        thrd_stack_free(self_p->listener.thrd.stack.buf_p);
+        connections_stack_free(self_p, number_of_connections);
         nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
                                            "http_server_init() failed"));
     }
@@ -442,6 +2044,19 @@ static mp_obj_t class_http_server_wrap_ssl(mp_obj_t self_in,
 #endif
 }
 
+/**
+ * def add_route(self, route)
+ *
+ * Add given route tuple (path, callback[, action[, exact]]).
+ */
+static mp_obj_t class_http_server_add_route(mp_obj_t self_in,
+                                            mp_obj_t route_in)
+{
+    route_add_tuple(MP_OBJ_TO_PTR(self_in), route_in);
+
+    return (mp_const_none);
+}
+
 /**
  * def start(self)
  */
@@ -449,12 +2064,18 @@ static mp_obj_t class_http_server_start(mp_obj_t self_in)
 {
     struct class_http_server_t *self_p;
     void *thread_p;
+    int i;
 
     self_p = MP_OBJ_TO_PTR(self_in);
 
     thread_p = mp_thread_add_begin();
     http_server_start(&self_p->http_server);
-    mp_thread_add_end(thread_p, self_p->connections[0].thrd.id_p);
+    mp_thread_add_end(thread_p, self_p->connections_p[0].thrd.id_p);
+
+    for (i = 1; i < self_p->number_of_connections; i++) {
+        thread_p = mp_thread_add_begin();
+        mp_thread_add_end(thread_p, self_p->connections_p[i].thrd.id_p);
+    }
 
     return (mp_const_none);
 }
@@ -472,15 +2093,76 @@ static mp_obj_t class_http_server_stop(mp_obj_t self_in)
     return (mp_const_none);
 }
 
+/**
+ * Request statistics fields.
+ */
+static const qstr statistics_fields[] = {
+    MP_QSTR_requests,
+    MP_QSTR_rejected,
+    MP_QSTR_queue_depth,
+    MP_QSTR_queue_depth_max,
+    MP_QSTR_latency_average,
+    MP_QSTR_latency_max
+};
+
+/**
+ * def statistics(self)
+ *
+ * Returns a named tuple of the number of handled and rejected
+ * requests, the current and maximum number of requests waiting for a
+ * worker, and the average and maximum handler latency in
+ * microseconds.
+ */
+static mp_obj_t class_http_server_statistics(mp_obj_t self_in)
+{
+    struct class_http_server_t *self_p;
+    struct class_http_server_statistics_t statistics;
+    int queue_depth;
+    mp_obj_t tuple[6];
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+
+    sys_lock();
+    statistics = self_p->statistics;
+    queue_depth = (self_p->pending - self_p->number_of_workers);
+    sys_unlock();
+
+    if (queue_depth < 0) {
+        queue_depth = 0;
+    }
+
+    tuple[0] = mp_obj_new_int_from_uint(statistics.requests);
+    tuple[1] = mp_obj_new_int_from_uint(statistics.rejected);
+    tuple[2] = mp_obj_new_int(queue_depth);
+    tuple[3] = mp_obj_new_int(statistics.queue_depth_max);
+
+    if (statistics.requests > 0) {
+        tuple[4] = mp_obj_new_int_from_uint(statistics.latency_total
+                                            / statistics.requests);
+    } else {
+        tuple[4] = MP_OBJ_NEW_SMALL_INT(0);
+    }
+
+    tuple[5] = mp_obj_new_int_from_uint(statistics.latency_max);
+
+    return (mp_obj_new_attrtuple(&statistics_fields[0],
+                                 membersof(tuple),
+                                 tuple));
+}
+
 static MP_DEFINE_CONST_FUN_OBJ_2(class_http_server_wrap_ssl_obj, class_http_server_wrap_ssl);
+static MP_DEFINE_CONST_FUN_OBJ_2(class_http_server_add_route_obj, class_http_server_add_route);
 static MP_DEFINE_CONST_FUN_OBJ_1(class_http_server_start_obj, class_http_server_start);
 static MP_DEFINE_CONST_FUN_OBJ_1(class_http_server_stop_obj, class_http_server_stop);
+static MP_DEFINE_CONST_FUN_OBJ_1(class_http_server_statistics_obj, class_http_server_statistics);
 
 static const mp_rom_map_elem_t class_http_server_locals_dict_table[] = {
     /* Instance methods. */
     { MP_ROM_QSTR(MP_QSTR_wrap_ssl), MP_ROM_PTR(&class_http_server_wrap_ssl_obj) },
+    { MP_ROM_QSTR(MP_QSTR_add_route), MP_ROM_PTR(&class_http_server_add_route_obj) },
     { MP_ROM_QSTR(MP_QSTR_start), MP_ROM_PTR(&class_http_server_start_obj) },
     { MP_ROM_QSTR(MP_QSTR_stop), MP_ROM_PTR(&class_http_server_stop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_statistics), MP_ROM_PTR(&class_http_server_statistics_obj) },
 
     /* Module constants. */
     { MP_ROM_QSTR(MP_QSTR_GET),
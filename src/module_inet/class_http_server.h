@@ -33,24 +33,137 @@
 
 #include "pumbaa.h"
 
+/**
+ * A registered route callback. Action is -1 for all actions.
+ */
+struct class_http_server_route_t {
+    mp_obj_t path;
+    mp_obj_t callback;
+    int action;
+    int exact;
+    struct class_http_server_route_t *next_p;
+};
+
+/**
+ * A node in the route radix tree. The label is a part of the path of
+ * the routes in the subtree.
+ */
+struct class_http_server_route_node_t {
+    const char *label_p;
+    size_t length;
+    struct class_http_server_route_node_t *child_p;
+    struct class_http_server_route_node_t *sibling_p;
+    struct class_http_server_route_t *routes_p;
+};
+
+/**
+ * Request statistics of the worker pool. Latencies are in
+ * microseconds.
+ */
+struct class_http_server_statistics_t {
+    unsigned long requests;
+    unsigned long rejected;
+    int queue_depth_max;
+    unsigned long long latency_total;
+    unsigned long latency_max;
+};
+
+/**
+ * State of a connection thread. Accept-Encoding and If-None-Match are
+ * not kept by the Simba request parser, so they are only known for
+ * requests parsed by Pumbaa, that is, kept alive requests after the
+ * first one on a connection.
+ */
+struct class_http_server_connection_state_t {
+    uint8_t stream_buf[CONFIG_PUMBAA_CLASS_HTTP_SERVER_STREAM_BUFFER_SIZE];
+    int headers_valid;
+    int accept_gzip;
+    char if_none_match[48];
+};
+
+/**
+ * Route callbacks are called by at most number_of_workers connection
+ * threads at a time. Up to queue_size more connection threads wait for
+ * a worker, and one more responds with 503 Service Unavailable when
+ * the queue is full. The queue size is -1 if it is unbounded, in which
+ * case there is one connection thread per worker.
+ */
 struct class_http_server_t {
     mp_obj_base_t base;
+    struct class_http_server_route_node_t root;
     struct http_server_t http_server;
     struct http_server_listener_t listener;
-    struct http_server_connection_t connections[2];
+    struct http_server_connection_t *connections_p;
+    int number_of_connections;
     struct http_server_route_t empty_routes[1];
     mp_obj_t routes;
     mp_obj_t no_route;
     mp_obj_t ssl_context_obj;
+    int max_requests;
+    struct time_t idle_timeout;
+    int number_of_workers;
+    int queue_size;
+    int pending;
+    struct sem_t workers_sem;
+    struct class_http_server_statistics_t statistics;
+    struct class_http_server_connection_state_t *states_p;
 };
 
+/**
+ * The CRC-32 of a served file. The entry is valid as long as the file
+ * size is unchanged.
+ */
+struct class_http_server_static_etag_t {
+    char path[128];
+    unsigned long size;
+    uint32_t crc;
+};
+
+/**
+ * Static files route callback. Files are served from given root
+ * directory by the server, without calling into Python. The CRC-32 of
+ * the most recently served files are cached to calculate ETags
+ * without reading the files.
+ */
+struct class_http_server_static_t {
+    mp_obj_base_t base;
+    mp_obj_t root;
+    struct sem_t sem;
+    int next;
+    struct class_http_server_static_etag_t etags[
+        CONFIG_PUMBAA_CLASS_HTTP_SERVER_STATIC_ETAG_CACHE_MAX];
+};
+
+/**
+ * The connection of a request. It is closed when the route callback
+ * returns, as the Simba connection is then reused for the next
+ * request, possibly from another client. WebSocket frames may be
+ * written to the connection from other threads, so frame writes and
+ * closing the connection are serialized by the write semaphore.
+ */
 struct class_http_server_connection_t {
     mp_obj_base_t base;
     struct http_server_connection_t *connection_p;
     struct http_server_request_t *request_p;
+    long content_left;
+    struct sem_t write_sem;
+    int closed;
+};
+
+/**
+ * A request is a view of the Simba request. Python objects are only
+ * created for fields that are accessed, and are cached in
+ * fields. The view is closed when the route callback returns.
+ */
+struct class_http_server_request_t {
+    mp_obj_base_t base;
+    struct http_server_request_t *request_p;
+    mp_obj_t fields[5];
 };
 
 extern const mp_obj_type_t module_inet_class_http_server;
 extern const mp_obj_type_t module_inet_class_http_server_connection;
+extern const mp_obj_type_t module_inet_class_http_server_request;
+extern const mp_obj_type_t module_inet_class_http_server_static;
 
 #endif
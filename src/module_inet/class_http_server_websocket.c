@@ -32,6 +32,24 @@
 
 #if CONFIG_PUMBAA_CLASS_HTTP_SERVER_WEBSOCKET == 1
 
+/**
+ * WebSocket frame opcodes.
+ */
+#define OPCODE_CONTINUATION                                 0x0
+#define OPCODE_TEXT                                         0x1
+#define OPCODE_BINARY                                       0x2
+#define OPCODE_CLOSE                                        0x8
+#define OPCODE_PING                                         0x9
+#define OPCODE_PONG                                         0xa
+
+/**
+ * Returns true if given WebSocket is closed.
+ */
+static int websocket_is_closed(struct class_http_server_websocket_t *self_p)
+{
+    return ((self_p->closed == 1) || (self_p->connection_p->closed == 1));
+}
+
 /**
  * Print the http_server_websocket object.
  */
@@ -81,6 +99,9 @@ static mp_obj_t class_http_server_websocket_make_new(const mp_obj_type_t *type_p
     /* Create a new HttpWebsocketServer object. */
     self_p = m_new_obj(struct class_http_server_websocket_t);
     self_p->base.type = &module_inet_class_http_server_websocket;
+    self_p->chan_p = connection_p->connection_p->chan_p;
+    self_p->connection_p = connection_p;
+    self_p->closed = 0;
 
     if (http_websocket_server_init(&self_p->http_server_websocket,
                                    &connection_p->connection_p->socket) != 0) {
@@ -182,6 +203,7 @@ static mp_obj_t class_http_server_websocket_write(mp_uint_t n_args,
     size_t size;
     ssize_t res;
     int type;
+    int closed;
 
     self_p = MP_OBJ_TO_PTR(args_p[0]);
     mp_get_buffer_raise(MP_OBJ_TO_PTR(args_p[1]),
@@ -201,14 +223,170 @@ static mp_obj_t class_http_server_websocket_write(mp_uint_t n_args,
     }
 
     type = HTTP_TYPE_TEXT;
-    res = http_websocket_server_write(&self_p->http_server_websocket,
-                                      type,
-                                      buffer_info.buf,
-                                      size);
+
+    /* Frames may be broadcast to this WebSocket from other
+       threads. */
+    sem_take(&self_p->connection_p->write_sem, NULL);
+    closed = websocket_is_closed(self_p);
+
+    if (closed == 0) {
+        res = http_websocket_server_write(&self_p->http_server_websocket,
+                                          type,
+                                          buffer_info.buf,
+                                          size);
+    }
+
+    sem_give(&self_p->connection_p->write_sem, 1);
+
+    if (closed == 1) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
+                                           "connection closed"));
+    }
 
     return (MP_OBJ_NEW_SMALL_INT(res));
 }
 
+/**
+ * Read exactly given number of bytes from given channel. Returns
+ * zero(0) or negative error code.
+ */
+static int chan_read_all(void *chan_p, void *buf_p, size_t size)
+{
+    if (size == 0) {
+        return (0);
+    }
+
+    if (chan_read(chan_p, buf_p, size) != size) {
+        return (-EIO);
+    }
+
+    return (0);
+}
+
+/**
+ * Read the next frame from given WebSocket and unmask its payload
+ * into given buffer. The part of the payload that does not fit in the
+ * buffer is discarded. Returns the payload size, which is greater
+ * than the buffer size if the payload was truncated, or negative
+ * error code.
+ */
+static ssize_t read_frame(struct class_http_server_websocket_t *self_p,
+                          int *opcode_p,
+                          uint8_t *buf_p,
+                          size_t size)
+{
+    uint8_t header[8];
+    uint8_t mask[4];
+    uint8_t discard[32];
+    uint64_t payload_size;
+    size_t left;
+    size_t i;
+
+    if (chan_read_all(self_p->chan_p, &header[0], 2) != 0) {
+        return (-EIO);
+    }
+
+    *opcode_p = (header[0] & 0x0f);
+    payload_size = (header[1] & 0x7f);
+
+    if (payload_size == 126) {
+        if (chan_read_all(self_p->chan_p, &header[0], 2) != 0) {
+            return (-EIO);
+        }
+
+        payload_size = ((header[0] << 8) | header[1]);
+    } else if (payload_size == 127) {
+        if (chan_read_all(self_p->chan_p, &header[0], 8) != 0) {
+            return (-EIO);
+        }
+
+        payload_size = 0;
+
+        for (i = 0; i < 8; i++) {
+            payload_size = ((payload_size << 8) | header[i]);
+        }
+
+        if (payload_size > INT32_MAX) {
+            return (-EMSGSIZE);
+        }
+    }
+
+    /* Client frames are masked. */
+    if (header[1] & 0x80) {
+        if (chan_read_all(self_p->chan_p, &mask[0], sizeof(mask)) != 0) {
+            return (-EIO);
+        }
+    } else {
+        memset(&mask[0], 0, sizeof(mask));
+    }
+
+    size = MIN(payload_size, size);
+
+    if (chan_read_all(self_p->chan_p, buf_p, size) != 0) {
+        return (-EIO);
+    }
+
+    for (i = 0; i < size; i++) {
+        buf_p[i] ^= mask[i % 4];
+    }
+
+    left = (payload_size - size);
+
+    while (left > 0) {
+        size = MIN(left, sizeof(discard));
+
+        if (chan_read_all(self_p->chan_p, &discard[0], size) != 0) {
+            return (-EIO);
+        }
+
+        left -= size;
+    }
+
+    return (payload_size);
+}
+
+/**
+ * def read_frame_into(self, buffer)
+ *
+ * Read the payload of the next frame into given buffer. Returns a
+ * tuple of the frame opcode and the payload length. The payload was
+ * truncated if its length is greater than the buffer length, in
+ * which case the rest of it is discarded.
+ */
+static mp_obj_t class_http_server_websocket_read_frame_into(mp_obj_t self_in,
+                                                            mp_obj_t buffer_in)
+{
+    struct class_http_server_websocket_t *self_p;
+    mp_buffer_info_t buffer_info;
+    ssize_t res;
+    int type;
+    mp_obj_t tuple[2];
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+    mp_get_buffer_raise(buffer_in, &buffer_info, MP_BUFFER_WRITE);
+
+    MODULE_THREAD_PARK(res = read_frame(self_p,
+                                        &type,
+                                        buffer_info.buf,
+                                        buffer_info.len));
+
+    if (res < 0) {
+        self_p->closed = 1;
+        mp_raise_OSError(MP_EIO);
+    }
+
+    if (type == OPCODE_CLOSE) {
+        self_p->closed = 1;
+    }
+
+    tuple[0] = MP_OBJ_NEW_SMALL_INT(type);
+    tuple[1] = mp_obj_new_int(res);
+
+    return (mp_obj_new_tuple(2, tuple));
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_2(class_http_server_websocket_read_frame_into_obj,
+                                 class_http_server_websocket_read_frame_into);
 static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(class_http_server_websocket_read_obj,
                                            1,
                                            2,
@@ -230,6 +408,16 @@ static const mp_rom_map_elem_t class_http_server_websocket_locals_dict_table[] =
       MP_ROM_PTR(&class_http_server_websocket_read_into_obj) },
     { MP_ROM_QSTR(MP_QSTR_write),
       MP_ROM_PTR(&class_http_server_websocket_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_read_frame_into),
+      MP_ROM_PTR(&class_http_server_websocket_read_frame_into_obj) },
+
+    /* Class constants. */
+    { MP_ROM_QSTR(MP_QSTR_OPCODE_CONTINUATION), MP_ROM_INT(OPCODE_CONTINUATION) },
+    { MP_ROM_QSTR(MP_QSTR_OPCODE_TEXT), MP_ROM_INT(OPCODE_TEXT) },
+    { MP_ROM_QSTR(MP_QSTR_OPCODE_BINARY), MP_ROM_INT(OPCODE_BINARY) },
+    { MP_ROM_QSTR(MP_QSTR_OPCODE_CLOSE), MP_ROM_INT(OPCODE_CLOSE) },
+    { MP_ROM_QSTR(MP_QSTR_OPCODE_PING), MP_ROM_INT(OPCODE_PING) },
+    { MP_ROM_QSTR(MP_QSTR_OPCODE_PONG), MP_ROM_INT(OPCODE_PONG) }
 };
 
 static MP_DEFINE_CONST_DICT(class_http_server_websocket_locals_dict,
@@ -246,4 +434,235 @@ const mp_obj_type_t module_inet_class_http_server_websocket = {
     .locals_dict = (mp_obj_t)&class_http_server_websocket_locals_dict,
 };
 
+/**
+ * Create a new WebSocket group.
+ */
+static mp_obj_t class_http_server_websocket_group_make_new(const mp_obj_type_t *type_p,
+                                                           mp_uint_t n_args,
+                                                           mp_uint_t n_kw,
+                                                           const mp_obj_t *args_p)
+{
+    struct class_http_server_websocket_group_t *self_p;
+
+    mp_arg_check_num(n_args, n_kw, 0, 0, false);
+
+    self_p = m_new_obj(struct class_http_server_websocket_group_t);
+    self_p->base.type = &module_inet_class_http_server_websocket_group;
+    self_p->members = mp_obj_new_list(0, NULL);
+
+    return (self_p);
+}
+
+/**
+ * def add(self, websocket)
+ */
+static mp_obj_t class_http_server_websocket_group_add(mp_obj_t self_in,
+                                                      mp_obj_t websocket_in)
+{
+    struct class_http_server_websocket_group_t *self_p;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+
+    if (!MP_OBJ_IS_TYPE(websocket_in, &module_inet_class_http_server_websocket)) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_TypeError,
+                                           "expected a WebSocket"));
+    }
+
+    mp_obj_list_append(self_p->members, websocket_in);
+
+    return (mp_const_none);
+}
+
+/**
+ * def remove(self, websocket)
+ */
+static mp_obj_t class_http_server_websocket_group_remove(mp_obj_t self_in,
+                                                         mp_obj_t websocket_in)
+{
+    struct class_http_server_websocket_group_t *self_p;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+    mp_obj_list_remove(self_p->members, websocket_in);
+
+    return (mp_const_none);
+}
+
+/**
+ * Pack a WebSocket frame header with given opcode and payload size
+ * into given buffer. Server frames are not masked. Returns the header
+ * size.
+ */
+static size_t frame_header_pack(uint8_t *header_p, int opcode, size_t size)
+{
+    size_t header_size;
+    int i;
+
+    header_p[0] = (0x80 | opcode);
+
+    if (size < 126) {
+        header_p[1] = size;
+        header_size = 2;
+    } else if (size < 65536) {
+        header_p[1] = 126;
+        header_p[2] = (size >> 8);
+        header_p[3] = size;
+        header_size = 4;
+    } else {
+        header_p[1] = 127;
+
+        for (i = 0; i < 8; i++) {
+            header_p[9 - i] = ((uint64_t)size >> (8 * i));
+        }
+
+        header_size = 10;
+    }
+
+    return (header_size);
+}
+
+/**
+ * def broadcast(self, buffer[, opcode])
+ *
+ * Write given buffer as one frame to all WebSockets in the group. The
+ * frame header is packed once. Control frames, with opcode 0x8 and
+ * above, can have at most 125 bytes of payload. Closed WebSockets and
+ * WebSockets that fail to be written to are removed from the
+ * group. Returns the number of WebSockets written to.
+ */
+static mp_obj_t class_http_server_websocket_group_broadcast(mp_uint_t n_args,
+                                                            const mp_obj_t *args_p)
+{
+    struct class_http_server_websocket_group_t *self_p;
+    struct class_http_server_websocket_t *websocket_p;
+    mp_buffer_info_t buffer_info;
+    uint8_t header[10];
+    size_t header_size;
+    mp_uint_t len;
+    mp_obj_t *items_p;
+    mp_obj_t failed;
+    int opcode;
+    int count;
+    int res;
+    mp_uint_t i;
+
+    self_p = MP_OBJ_TO_PTR(args_p[0]);
+    mp_get_buffer_raise(args_p[1], &buffer_info, MP_BUFFER_READ);
+
+    if (n_args == 3) {
+        opcode = mp_obj_get_int(args_p[2]);
+
+        if ((opcode < 0) || (opcode > 0xf)) {
+            nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+                                               "bad opcode"));
+        }
+    } else {
+        opcode = OPCODE_TEXT;
+    }
+
+    if ((opcode >= OPCODE_CLOSE) && (buffer_info.len > 125)) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+                                           "control frame too long"));
+    }
+
+    header_size = frame_header_pack(&header[0], opcode, buffer_info.len);
+    mp_obj_list_get(self_p->members, &len, &items_p);
+    failed = MP_OBJ_NULL;
+    count = 0;
+
+    for (i = 0; i < len; i++) {
+        websocket_p = MP_OBJ_TO_PTR(items_p[i]);
+
+        /* Do not interleave the frame with frames written by the
+           connection thread, or write to a closed connection. */
+        sem_take(&websocket_p->connection_p->write_sem, NULL);
+
+        if ((websocket_is_closed(websocket_p) == 0)
+            && (chan_write(websocket_p->chan_p,
+                           &header[0],
+                           header_size) == header_size)
+            && (chan_write(websocket_p->chan_p,
+                           buffer_info.buf,
+                           buffer_info.len) == buffer_info.len)) {
+            res = 0;
+        } else {
+            websocket_p->closed = 1;
+            res = -1;
+        }
+
+        sem_give(&websocket_p->connection_p->write_sem, 1);
+
+        if (res == 0) {
+            count++;
+        } else {
+            if (failed == MP_OBJ_NULL) {
+                failed = mp_obj_new_list(0, NULL);
+            }
+
+            mp_obj_list_append(failed, items_p[i]);
+        }
+    }
+
+    /* Remove closed WebSockets and WebSockets that could not be
+       written to. */
+    if (failed != MP_OBJ_NULL) {
+        mp_obj_list_get(failed, &len, &items_p);
+
+        for (i = 0; i < len; i++) {
+            mp_obj_list_remove(self_p->members, items_p[i]);
+        }
+    }
+
+    return (MP_OBJ_NEW_SMALL_INT(count));
+}
+
+/**
+ * Number of WebSockets in the group.
+ */
+static mp_obj_t class_http_server_websocket_group_unary_op(mp_uint_t op,
+                                                           mp_obj_t self_in)
+{
+    struct class_http_server_websocket_group_t *self_p;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+
+    if (op == MP_UNARY_OP_LEN) {
+        return (mp_obj_len(self_p->members));
+    }
+
+    return (MP_OBJ_NULL);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_2(class_http_server_websocket_group_add_obj,
+                                 class_http_server_websocket_group_add);
+static MP_DEFINE_CONST_FUN_OBJ_2(class_http_server_websocket_group_remove_obj,
+                                 class_http_server_websocket_group_remove);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(class_http_server_websocket_group_broadcast_obj,
+                                           2,
+                                           3,
+                                           class_http_server_websocket_group_broadcast);
+
+static const mp_rom_map_elem_t class_http_server_websocket_group_locals_dict_table[] = {
+    /* Instance methods. */
+    { MP_ROM_QSTR(MP_QSTR_add),
+      MP_ROM_PTR(&class_http_server_websocket_group_add_obj) },
+    { MP_ROM_QSTR(MP_QSTR_remove),
+      MP_ROM_PTR(&class_http_server_websocket_group_remove_obj) },
+    { MP_ROM_QSTR(MP_QSTR_broadcast),
+      MP_ROM_PTR(&class_http_server_websocket_group_broadcast_obj) },
+};
+
+static MP_DEFINE_CONST_DICT(class_http_server_websocket_group_locals_dict,
+                            class_http_server_websocket_group_locals_dict_table);
+
+/**
+ * Http_Server_Websocket_Group class type.
+ */
+const mp_obj_type_t module_inet_class_http_server_websocket_group = {
+    { &mp_type_type },
+    .name = MP_QSTR_HttpServerWebSocketGroup,
+    .make_new = class_http_server_websocket_group_make_new,
+    .unary_op = class_http_server_websocket_group_unary_op,
+    .locals_dict = (mp_obj_t)&class_http_server_websocket_group_locals_dict,
+};
+
 #endif
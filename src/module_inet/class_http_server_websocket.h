@@ -33,11 +33,27 @@
 
 #include "pumbaa.h"
 
+/**
+ * A WebSocket is closed when a close frame is read, when a read
+ * fails, or when the connection it was upgraded from is closed.
+ */
 struct class_http_server_websocket_t {
     mp_obj_base_t base;
     struct http_websocket_server_t http_server_websocket;
+    void *chan_p;
+    struct class_http_server_connection_t *connection_p;
+    int closed;
+};
+
+/**
+ * A group of WebSockets that messages are broadcast to.
+ */
+struct class_http_server_websocket_group_t {
+    mp_obj_base_t base;
+    mp_obj_t members;
 };
 
 extern const mp_obj_type_t module_inet_class_http_server_websocket;
+extern const mp_obj_type_t module_inet_class_http_server_websocket_group;
 
 #endif
@@ -245,6 +245,28 @@ static const mp_obj_type_t class_textio = {
     .locals_dict = (mp_obj_dict_t*)&rawfile_locals_dict,
 };
 
+struct fs_file_t *module_io_file_get(mp_obj_t file_in)
+{
+    struct file_obj_t *file_p;
+    const mp_obj_type_t *type_p;
+
+    type_p = mp_obj_get_type(file_in);
+
+#if MICROPY_PY_IO_FILEIO == 1
+    if ((type_p != &class_textio) && (type_p != &class_fileio)) {
+        return (NULL);
+    }
+#else
+    if (type_p != &class_textio) {
+        return (NULL);
+    }
+#endif
+
+    file_p = MP_OBJ_TO_PTR(file_in);
+
+    return (&file_p->file);
+}
+
 /**
  * Helper function to open a file.
  */
@@ -297,6 +319,11 @@ static mp_obj_t file_open(const mp_obj_type_t *type_p,
     obj_p->base.type = type_p;
 
     fname_p = mp_obj_str_get_str(args_p[0].u_obj);
+
+    if (mode & FS_WRITE) {
+        PORT_IMPORT_STAT_CACHE_INVALIDATE();
+    }
+
     res = fs_open(&obj_p->file, fname_p, mode);
 
     if (res != 0) {
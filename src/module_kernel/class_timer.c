@@ -31,7 +31,8 @@
 #include "pumbaa.h"
 
 /**
- * Timer timeout callback. Called from an interrupt.
+ * Timer timeout callback. Called from an interrupt. The Python
+ * callback is scheduled to be called by the VM.
  */
 static void timer_cb_isr(void *self_in)
 {
@@ -40,7 +41,7 @@ static void timer_cb_isr(void *self_in)
     self_p = MP_OBJ_TO_PTR(self_in);
 
     if (self_p->callback != mp_const_none) {
-        mp_call_function_0(self_p->callback);
+        sched_port_schedule_isr(self_p->callback, MP_OBJ_NULL);
     }
 
     if (self_p->event_obj_p != mp_const_none) {
@@ -159,6 +159,7 @@ static mp_obj_t os_mkdir(mp_obj_t path_in)
     int res;
 
     path_p = mp_obj_str_get_str(path_in);
+    PORT_IMPORT_STAT_CACHE_INVALIDATE();
     res = fs_mkdir(path_p);
 
     if (res != 0) {
@@ -182,6 +183,7 @@ static mp_obj_t os_remove(mp_obj_t path_in)
     int res;
 
     path_p = mp_obj_str_get_str(path_in);
+    PORT_IMPORT_STAT_CACHE_INVALIDATE();
     res = fs_remove(path_p);
 
     if (res != 0) {
@@ -362,6 +364,7 @@ static mp_obj_t os_format(mp_obj_t path_in)
 {
     int res;
 
+    PORT_IMPORT_STAT_CACHE_INVALIDATE();
     res = fs_format(mp_obj_str_get_str(path_in));
 
     if (res != 0) {
@@ -377,6 +380,58 @@ static MP_DEFINE_CONST_FUN_OBJ_1(os_format_obj, os_format);
 
 #endif
 
+#if CONFIG_PUMBAA_BYTECODE_CACHE == 1
+
+/**
+ * Returns a tuple of the number of imports served from the bytecode
+ * cache and the number of imports that compiled the source file.
+ *
+ * def bytecode_cache_info()
+ */
+static mp_obj_t os_bytecode_cache_info(void)
+{
+    unsigned long hits;
+    unsigned long misses;
+    mp_obj_t items[2];
+
+    bytecode_cache_port_get_info(&hits, &misses);
+    items[0] = mp_obj_new_int_from_uint(hits);
+    items[1] = mp_obj_new_int_from_uint(misses);
+
+    return (mp_obj_new_tuple(2, items));
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_0(os_bytecode_cache_info_obj,
+                                 os_bytecode_cache_info);
+
+#endif
+
+#if CONFIG_PUMBAA_IMPORT_STAT_CACHE == 1
+
+/**
+ * Returns a tuple of the number of import lookups served from a
+ * cached directory listing and the number of directories read.
+ *
+ * def import_stat_cache_info()
+ */
+static mp_obj_t os_import_stat_cache_info(void)
+{
+    unsigned long hits;
+    unsigned long misses;
+    mp_obj_t items[2];
+
+    port_import_stat_cache_get_info(&hits, &misses);
+    items[0] = mp_obj_new_int_from_uint(hits);
+    items[1] = mp_obj_new_int_from_uint(misses);
+
+    return (mp_obj_new_tuple(2, items));
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_0(os_import_stat_cache_info_obj,
+                                 os_import_stat_cache_info);
+
+#endif
+
 static MP_DEFINE_CONST_FUN_OBJ_0(os_uname_obj, os_uname);
 static MP_DEFINE_CONST_FUN_OBJ_1(os_chdir_obj, os_chdir);
 static MP_DEFINE_CONST_FUN_OBJ_0(os_getcwd_obj, os_getcwd);
@@ -408,6 +463,12 @@ static const mp_rom_map_elem_t module_os_globals_table[] = {
 #if CONFIG_PUMBAA_OS_FORMAT == 1
     { MP_ROM_QSTR(MP_QSTR_format), MP_ROM_PTR(&os_format_obj) },
 #endif
+#if CONFIG_PUMBAA_BYTECODE_CACHE == 1
+    { MP_ROM_QSTR(MP_QSTR_bytecode_cache_info), MP_ROM_PTR(&os_bytecode_cache_info_obj) },
+#endif
+#if CONFIG_PUMBAA_IMPORT_STAT_CACHE == 1
+    { MP_ROM_QSTR(MP_QSTR_import_stat_cache_info), MP_ROM_PTR(&os_import_stat_cache_info_obj) },
+#endif
 };
 
 static MP_DEFINE_CONST_DICT(module_os_globals, module_os_globals_table);
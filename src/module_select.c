@@ -32,6 +32,11 @@
 
 #define CHAN_POLLIN   1
 #define CHAN_POLLHUP  2
+#define CHAN_POLLOUT  4
+
+/* Initial number of entries in the registration table. The table
+   doubles in size when full. */
+#define POLL_ENTRIES_MIN 8
 
 extern const mp_obj_type_t module_socket_class_socket;
 extern const mp_obj_type_t module_ssl_class_ssl_socket;
@@ -41,10 +46,24 @@ struct class_chan_t {
     struct chan_t chan;
 };
 
+struct poll_entry_t {
+    mp_obj_t obj;
+    mp_uint_t eventmask;
+};
+
 struct class_poll_t {
     mp_obj_base_t base;
     struct chan_list_t list;
-    void *workspace[32];
+    void **workspace_pp;
+    struct poll_entry_t *entries_p;
+    size_t length;
+    size_t max;
+    struct {
+        mp_obj_tuple_t *tuple_p;
+        struct chan_t *woken_p;
+        size_t index;
+        int armed;
+    } ipoll;
 };
 
 /**
@@ -58,6 +77,9 @@ static int is_channel(mp_obj_t obj)
 #if CONFIG_PUMBAA_MODULE_SOCKET == 1
             || MP_OBJ_IS_TYPE(obj, &module_socket_class_socket)
 #endif
+#if CONFIG_PUMBAA_MODULE_SSL == 1
+            || MP_OBJ_IS_TYPE(obj, &module_ssl_class_ssl_socket)
+#endif
 #if CONFIG_PUMBAA_CLASS_CAN == 1
             || MP_OBJ_IS_TYPE(obj, &module_drivers_class_can)
 #endif
@@ -67,14 +89,243 @@ static int is_channel(mp_obj_t obj)
             );
 }
 
+/**
+ * Returns the channel that wakes up the poller for given entry. An
+ * SSL socket is woken up by records arriving on the wrapped socket.
+ */
+static struct chan_t *entry_chan(struct poll_entry_t *entry_p)
+{
+    struct class_chan_t *chan_p;
+
+#if CONFIG_PUMBAA_MODULE_SSL == 1
+    struct class_ssl_socket_t *ssl_socket_p;
+
+    if (MP_OBJ_IS_TYPE(entry_p->obj, &module_ssl_class_ssl_socket)) {
+        ssl_socket_p = MP_OBJ_TO_PTR(entry_p->obj);
+        chan_p = MP_OBJ_TO_PTR(ssl_socket_p->sock_obj);
+
+        return (&chan_p->chan);
+    }
+#endif
+
+    chan_p = MP_OBJ_TO_PTR(entry_p->obj);
+
+    return (&chan_p->chan);
+}
+
+/**
+ * Returns the number of bytes available to read from given entry. An
+ * SSL socket is readable if decrypted data is buffered in the SSL
+ * layer, or if a record is pending on the wrapped socket.
+ */
+static ssize_t entry_size(struct poll_entry_t *entry_p)
+{
+    ssize_t size;
+#if CONFIG_PUMBAA_MODULE_SSL == 1
+    struct class_ssl_socket_t *ssl_socket_p;
+#endif
+
+    size = chan_size(entry_chan(entry_p));
+
+#if CONFIG_PUMBAA_MODULE_SSL == 1
+    if (MP_OBJ_IS_TYPE(entry_p->obj, &module_ssl_class_ssl_socket)) {
+        ssl_socket_p = MP_OBJ_TO_PTR(entry_p->obj);
+
+        if (size < 0) {
+            size = 0;
+        }
+
+        size += ssl_socket_size(&ssl_socket_p->socket);
+    }
+#endif
+
+    return (size);
+}
+
+/**
+ * Returns the index of given object in the registration table, or -1
+ * if not registered.
+ */
+static int poll_find(struct class_poll_t *self_p, mp_obj_t obj)
+{
+    size_t i;
+
+    for (i = 0; i < self_p->length; i++) {
+        if (self_p->entries_p[i].obj == obj) {
+            return (i);
+        }
+    }
+
+    return (-1);
+}
+
+/**
+ * Initialize the Simba channel list with a workspace of given number
+ * of entries and add all registered channels to it.
+ */
+static int poll_list_init(struct class_poll_t *self_p, size_t max)
+{
+    size_t i;
+
+    self_p->workspace_pp = m_new(void *, max);
+
+    if (chan_list_init(&self_p->list,
+                       self_p->workspace_pp,
+                       sizeof(void *) * max) != 0) {
+        return (-1);
+    }
+
+    for (i = 0; i < self_p->length; i++) {
+        if (self_p->entries_p[i].eventmask == 0) {
+            continue;
+        }
+
+        if (chan_list_add(&self_p->list,
+                          entry_chan(&self_p->entries_p[i])) != 0) {
+            return (-1);
+        }
+    }
+
+    return (0);
+}
+
+/**
+ * Double the size of the registration table and the channel list.
+ */
+static int poll_grow(struct class_poll_t *self_p)
+{
+    size_t i;
+    size_t max;
+
+    max = (2 * self_p->max);
+
+    for (i = 0; i < self_p->length; i++) {
+        if (self_p->entries_p[i].eventmask != 0) {
+            chan_list_remove(&self_p->list,
+                             entry_chan(&self_p->entries_p[i]));
+        }
+    }
+
+    m_del(void *, self_p->workspace_pp, self_p->max);
+    self_p->entries_p = m_renew(struct poll_entry_t,
+                                self_p->entries_p,
+                                self_p->max,
+                                max);
+    self_p->max = max;
+
+    return (poll_list_init(self_p, max));
+}
+
+/**
+ * Returns the events that are active on given registered channel. A
+ * Simba channel write blocks until the data is written, so a channel
+ * is always writable and POLLOUT is always reported if
+ * requested. Register POLLOUT only to learn that a channel can be
+ * written to, never in a loop waiting for readers, as the poller then
+ * never waits.
+ *
+ * A channel that woke up the poller is readable even if it has no
+ * data, as a read then returns the end of stream, unless another
+ * reader emptied it first. POLLHUP is only reported if the channel
+ * size is an error, that is, the channel has been closed.
+ */
+static mp_uint_t poll_entry_revents(struct poll_entry_t *entry_p,
+                                    struct chan_t *woken_p)
+{
+    struct chan_t *chan_p;
+    mp_uint_t revents;
+    ssize_t size;
+
+    chan_p = entry_chan(entry_p);
+    size = entry_size(entry_p);
+    revents = 0;
+
+    if ((entry_p->eventmask & CHAN_POLLIN)
+        && ((size > 0) || ((chan_p == woken_p) && (size == 0)))) {
+        revents |= CHAN_POLLIN;
+    }
+
+    if (entry_p->eventmask & CHAN_POLLOUT) {
+        revents |= CHAN_POLLOUT;
+    }
+
+    if ((chan_p == woken_p) && (size < 0)) {
+        revents |= CHAN_POLLHUP;
+    }
+
+    return (revents);
+}
+
+/**
+ * Append a (obj, revents) tuple to given list for each registered
+ * channel with at least one active event. Returns the number of
+ * appended tuples.
+ */
+static int poll_collect(struct class_poll_t *self_p,
+                        struct chan_t *woken_p,
+                        mp_obj_t list)
+{
+    mp_obj_t tuple_items[2];
+    mp_uint_t revents;
+    size_t i;
+    int count;
+
+    count = 0;
+
+    for (i = 0; i < self_p->length; i++) {
+        revents = poll_entry_revents(&self_p->entries_p[i], woken_p);
+
+        if (revents != 0) {
+            tuple_items[0] = self_p->entries_p[i].obj;
+            tuple_items[1] = MP_OBJ_NEW_SMALL_INT(revents);
+            mp_obj_list_append(list, mp_obj_new_tuple(2, &tuple_items[0]));
+            count++;
+        }
+    }
+
+    return (count);
+}
+
+/**
+ * Set the event mask of given entry. A channel with an empty event
+ * mask is removed from the Simba channel list, so it cannot wake up
+ * the poller, and added back when its event mask becomes non-empty.
+ * Returns zero(0) on success, otherwise negative error code.
+ */
+static int poll_entry_set_eventmask(struct class_poll_t *self_p,
+                                    struct poll_entry_t *entry_p,
+                                    mp_uint_t eventmask)
+{
+    int res;
+
+    res = 0;
+
+    if ((entry_p->eventmask == 0) && (eventmask != 0)) {
+        res = chan_list_add(&self_p->list, entry_chan(entry_p));
+    } else if ((entry_p->eventmask != 0) && (eventmask == 0)) {
+        res = chan_list_remove(&self_p->list, entry_chan(entry_p));
+    }
+
+    if (res == 0) {
+        entry_p->eventmask = eventmask;
+    }
+
+    return (res);
+}
+
 /**
  * def register(obj[, eventmask])
+ *
+ * A channel is always writable, so a channel registered for POLLOUT
+ * makes poll() return immediately.
  */
 static mp_obj_t poll_register(size_t n_args, const mp_obj_t *args_p)
 {
     struct class_poll_t *self_p;
+    struct poll_entry_t *entry_p;
     mp_obj_t chan;
-    struct class_chan_t *chan_p;
+    mp_uint_t eventmask;
+    int index;
 
     chan = args_p[1];
 
@@ -84,15 +335,47 @@ static mp_obj_t poll_register(size_t n_args, const mp_obj_t *args_p)
                                            "channel object required"));
     }
 
-    /* Add the channel to the poll list. */
     self_p = MP_OBJ_TO_PTR(args_p[0]);
-    chan_p = MP_OBJ_TO_PTR(chan);
+    eventmask = CHAN_POLLIN;
+
+    if (n_args == 3) {
+        eventmask = mp_obj_get_int(args_p[2]);
+    }
 
-    if (chan_list_add(&self_p->list, &chan_p->chan) != 0) {
+    /* Registering an already registered channel modifies its event
+       mask. */
+    index = poll_find(self_p, chan);
+
+    if (index >= 0) {
+        if (poll_entry_set_eventmask(self_p,
+                                     &self_p->entries_p[index],
+                                     eventmask) != 0) {
+            nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
+                                               "cannot register channel"));
+        }
+
+        return (mp_const_none);
+    }
+
+    if (self_p->length == self_p->max) {
+        if (poll_grow(self_p) != 0) {
+            nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
+                                               "cannot register channel"));
+        }
+    }
+
+    /* Add the channel to the poll list. */
+    entry_p = &self_p->entries_p[self_p->length];
+    entry_p->obj = chan;
+    entry_p->eventmask = 0;
+
+    if (poll_entry_set_eventmask(self_p, entry_p, eventmask) != 0) {
         nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
                                            "cannot register channel"));
     }
 
+    self_p->length++;
+
     return (mp_const_none);
 }
 
@@ -102,16 +385,34 @@ static mp_obj_t poll_register(size_t n_args, const mp_obj_t *args_p)
 static mp_obj_t poll_unregister(mp_obj_t self_in, mp_obj_t obj_in)
 {
     struct class_poll_t *self_p;
-    struct class_chan_t *chan_p;
+    int index;
 
     self_p = MP_OBJ_TO_PTR(self_in);
-    chan_p = MP_OBJ_TO_PTR(obj_in);
+    index = poll_find(self_p, obj_in);
 
-    if (chan_list_remove(&self_p->list, &chan_p->chan) != 0) {
+    if (index < 0) {
         nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
                                            "cannot unregister channel"));
     }
 
+    if (poll_entry_set_eventmask(self_p, &self_p->entries_p[index], 0) != 0) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
+                                           "cannot unregister channel"));
+    }
+
+    /* Keep the table packed and in registration order. */
+    self_p->length--;
+    memmove(&self_p->entries_p[index],
+            &self_p->entries_p[index + 1],
+            sizeof(self_p->entries_p[0]) * (self_p->length - index));
+    self_p->entries_p[self_p->length].obj = MP_OBJ_NULL;
+
+    /* Do not skip any channel if unregistered while iterating over
+       ipoll() results. */
+    if ((size_t)index < self_p->ipoll.index) {
+        self_p->ipoll.index--;
+    }
+
     return (mp_const_none);
 }
 
@@ -120,64 +421,208 @@ static mp_obj_t poll_unregister(mp_obj_t self_in, mp_obj_t obj_in)
  */
 static mp_obj_t poll_modify(mp_obj_t self_in, mp_obj_t obj_in, mp_obj_t eventmask_in)
 {
+    struct class_poll_t *self_p;
+    int index;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+    index = poll_find(self_p, obj_in);
+
+    if (index < 0) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
+                                           "channel not registered"));
+    }
+
+    if (poll_entry_set_eventmask(self_p,
+                                 &self_p->entries_p[index],
+                                 mp_obj_get_int(eventmask_in)) != 0) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
+                                           "cannot modify channel"));
+    }
+
     return (mp_const_none);
 }
 
+/**
+ * Parse the optional timeout argument. Returns NULL if no timeout is
+ * given, otherwise given timeout struct.
+ */
+static struct time_t *parse_timeout(size_t n_args,
+                                    const mp_obj_t *args_p,
+                                    struct time_t *timeout_p)
+{
+    float f_timeout;
+
+    if (n_args < 2) {
+        return (NULL);
+    }
+
+    if (args_p[1] == mp_const_none) {
+        return (NULL);
+    }
+
+    f_timeout = mp_obj_get_float(args_p[1]);
+    timeout_p->seconds = (long)f_timeout;
+    timeout_p->nanoseconds = (f_timeout - timeout_p->seconds) * 1000000000L;
+
+    return (timeout_p);
+}
+
+/**
+ * Returns true(1) if at least one registered channel has an active
+ * event, otherwise false(0).
+ */
+static int poll_is_ready(struct class_poll_t *self_p,
+                         struct chan_t *woken_p)
+{
+    size_t i;
+
+    for (i = 0; i < self_p->length; i++) {
+        if (poll_entry_revents(&self_p->entries_p[i], woken_p) != 0) {
+            return (1);
+        }
+    }
+
+    return (0);
+}
+
+/**
+ * Wait for at least one registered channel to have an active event,
+ * or a timeout. Returns -ETIMEDOUT on timeout, otherwise zero(0) and
+ * the channel that woke the poller, if any, in woken_pp.
+ */
+static int poll_wait(struct class_poll_t *self_p,
+                     struct time_t *timeout_p,
+                     struct chan_t **woken_pp)
+{
+    *woken_pp = NULL;
+
+    /* Do not wait if a channel already has an event. */
+    if (poll_is_ready(self_p, NULL) == 1) {
+        return (0);
+    }
+
+    /* Poll the list of channel(s) waiting for an event or timeout (if
+       given). A timeout occured if NULL is returned. */
+    MODULE_THREAD_PARK(*woken_pp = chan_list_poll(&self_p->list, timeout_p));
+
+    if (*woken_pp == NULL) {
+        return (-ETIMEDOUT);
+    }
+
+    return (0);
+}
+
 /**
  * def poll([timeout])
  */
-static mp_obj_t poll_poll(size_t n_args, const mp_obj_t *args)
+static mp_obj_t poll_poll(size_t n_args, const mp_obj_t *args_p)
 {
     struct class_poll_t *self_p;
-    mp_obj_t tuple_items[2];
-    mp_obj_t list_items[1];
-    float f_timeout;
     struct time_t timeout;
     struct time_t *timeout_p;
-    void *chan_p;
-
-    self_p = MP_OBJ_TO_PTR(args[0]);
-    timeout_p = NULL;
-
-    /* Parse the timeout argument. */
-    if (n_args >= 2) {
-        if (args[1] != mp_const_none) {
-            f_timeout = mp_obj_get_float(args[1]);
-            timeout.seconds = (long)f_timeout;
-            timeout.nanoseconds = (f_timeout - timeout.seconds) * 1000000000L;
-            timeout_p = &timeout;
-        }
+    struct chan_t *woken_p;
+    mp_obj_t list;
+
+    self_p = MP_OBJ_TO_PTR(args_p[0]);
+    timeout_p = parse_timeout(n_args, args_p, &timeout);
+    list = mp_obj_new_list(0, NULL);
+
+    /* Return the empty list on timeout. */
+    if (poll_wait(self_p, timeout_p, &woken_p) != 0) {
+        return (list);
     }
 
-    /* Poll the list of channel(s) waiting for an event or timeout (if
-       given). */
-    chan_p = chan_list_poll(&self_p->list, timeout_p);
+    /* More channels may have become ready while the woken thread was
+       scheduled. Collect all of them. */
+    poll_collect(self_p, woken_p, list);
+
+    return (list);
+}
+
+/**
+ * def ipoll([timeout])
+ *
+ * Same as poll(), but returns an iterator over the ready channels
+ * instead of a list. The iterator is the poll object itself and the
+ * same (obj, revents) tuple is returned by each iteration, so no
+ * memory is allocated.
+ */
+static mp_obj_t poll_ipoll(size_t n_args, const mp_obj_t *args_p)
+{
+    struct class_poll_t *self_p;
+    struct time_t timeout;
+    struct time_t *timeout_p;
+
+    self_p = MP_OBJ_TO_PTR(args_p[0]);
+    timeout_p = parse_timeout(n_args, args_p, &timeout);
 
-    /* A timeout occured if NULL is returned. Return the empty
-       list. */
-    if (chan_p == NULL) {
-        return (mp_obj_new_list(0, NULL));
+    if (poll_wait(self_p, timeout_p, &self_p->ipoll.woken_p) == 0) {
+        self_p->ipoll.index = 0;
+    } else {
+        self_p->ipoll.index = self_p->length;
     }
 
-    /* No timeout. Return the a list containing the one channel with
-       an event. */
-    tuple_items[0] = container_of(chan_p, struct class_chan_t, chan);
-    tuple_items[1] = MP_OBJ_NEW_SMALL_INT(CHAN_POLLIN);
-    list_items[0] = mp_obj_new_tuple(2, &tuple_items[0]);
+    self_p->ipoll.armed = 1;
 
-    return (mp_obj_new_list(1, &list_items[0]));
+    return (self_p);
+}
+
+/**
+ * The poll object is only iterable as returned by ipoll(), as it
+ * would otherwise iterate over the results of an earlier call.
+ */
+static mp_obj_t poll_getiter(mp_obj_t self_in)
+{
+    struct class_poll_t *self_p;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+
+    if (self_p->ipoll.armed == 0) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_TypeError,
+                                           "iterate over ipoll()"));
+    }
+
+    self_p->ipoll.armed = 0;
+
+    return (self_in);
+}
+
+static mp_obj_t poll_iternext(mp_obj_t self_in)
+{
+    struct class_poll_t *self_p;
+    struct poll_entry_t *entry_p;
+    mp_uint_t revents;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+
+    while (self_p->ipoll.index < self_p->length) {
+        entry_p = &self_p->entries_p[self_p->ipoll.index];
+        self_p->ipoll.index++;
+        revents = poll_entry_revents(entry_p, self_p->ipoll.woken_p);
+
+        if (revents != 0) {
+            self_p->ipoll.tuple_p->items[0] = entry_p->obj;
+            self_p->ipoll.tuple_p->items[1] = MP_OBJ_NEW_SMALL_INT(revents);
+
+            return (MP_OBJ_FROM_PTR(self_p->ipoll.tuple_p));
+        }
+    }
+
+    return (MP_OBJ_STOP_ITERATION);
 }
 
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(poll_register_obj, 2, 3, poll_register);
 MP_DEFINE_CONST_FUN_OBJ_2(poll_unregister_obj, poll_unregister);
 MP_DEFINE_CONST_FUN_OBJ_3(poll_modify_obj, poll_modify);
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(poll_poll_obj, 1, 3, poll_poll);
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(poll_ipoll_obj, 1, 2, poll_ipoll);
 
 static const mp_rom_map_elem_t class_poll_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_register), MP_ROM_PTR(&poll_register_obj) },
     { MP_ROM_QSTR(MP_QSTR_unregister), MP_ROM_PTR(&poll_unregister_obj) },
     { MP_ROM_QSTR(MP_QSTR_modify), MP_ROM_PTR(&poll_modify_obj) },
     { MP_ROM_QSTR(MP_QSTR_poll), MP_ROM_PTR(&poll_poll_obj) },
+    { MP_ROM_QSTR(MP_QSTR_ipoll), MP_ROM_PTR(&poll_ipoll_obj) },
 };
 
 static MP_DEFINE_CONST_DICT(class_poll_locals_dict, class_poll_locals_dict_table);
@@ -185,6 +630,8 @@ static MP_DEFINE_CONST_DICT(class_poll_locals_dict, class_poll_locals_dict_table
 static const mp_obj_type_t class_poll = {
     { &mp_type_type },
     .name = MP_QSTR_poll,
+    .getiter = poll_getiter,
+    .iternext = poll_iternext,
     .locals_dict = (void*)&class_poll_locals_dict,
 };
 
@@ -194,10 +641,17 @@ static mp_obj_t select_poll(void)
 
     poll_p = m_new_obj(struct class_poll_t);
     poll_p->base.type = &class_poll;
-
-    if (chan_list_init(&poll_p->list,
-                       &poll_p->workspace[0],
-                       sizeof(poll_p->workspace)) != 0) {
+    poll_p->entries_p = m_new0(struct poll_entry_t, POLL_ENTRIES_MIN);
+    poll_p->length = 0;
+    poll_p->max = POLL_ENTRIES_MIN;
+    poll_p->ipoll.tuple_p = MP_OBJ_TO_PTR(mp_obj_new_tuple(2, NULL));
+    poll_p->ipoll.tuple_p->items[0] = mp_const_none;
+    poll_p->ipoll.tuple_p->items[1] = mp_const_none;
+    poll_p->ipoll.woken_p = NULL;
+    poll_p->ipoll.index = 0;
+    poll_p->ipoll.armed = 0;
+
+    if (poll_list_init(poll_p, POLL_ENTRIES_MIN) != 0) {
         nlr_raise(mp_obj_new_exception(&mp_type_OSError));
     }
 
@@ -211,6 +665,7 @@ static const mp_rom_map_elem_t mp_module_select_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_poll), MP_ROM_PTR(&mp_select_poll_obj) },
     { MP_ROM_QSTR(MP_QSTR_POLLIN), MP_ROM_INT(CHAN_POLLIN) },
     { MP_ROM_QSTR(MP_QSTR_POLLHUP), MP_ROM_INT(CHAN_POLLHUP) },
+    { MP_ROM_QSTR(MP_QSTR_POLLOUT), MP_ROM_INT(CHAN_POLLOUT) },
 };
 
 static MP_DEFINE_CONST_DICT(mp_module_select_globals, mp_module_select_globals_table);
@@ -40,6 +40,59 @@
 
 extern const mp_obj_type_t module_socket_class_socket;
 
+/**
+ * Wait for data to become available on given socket. Blocking
+ * sockets (no timeout) return immediately and let the Simba socket
+ * call block instead. Returns zero(0) if data is available, -MP_EAGAIN
+ * if the socket is non-blocking and no data is available, or
+ * -MP_ETIMEDOUT if the timeout expired.
+ */
+int module_socket_wait_readable(struct class_socket_t *self_p)
+{
+    struct chan_list_t list;
+    void *workspace[1];
+    void *chan_p;
+
+    if (self_p->timeout_p == NULL) {
+        return (0);
+    }
+
+    if (chan_size(&self_p->socket) > 0) {
+        return (0);
+    }
+
+    if ((self_p->timeout_p->seconds == 0)
+        && (self_p->timeout_p->nanoseconds == 0)) {
+        return (-MP_EAGAIN);
+    }
+
+    chan_list_init(&list, &workspace[0], sizeof(workspace));
+    chan_list_add(&list, &self_p->socket);
+    MODULE_THREAD_PARK(chan_p = chan_list_poll(&list, self_p->timeout_p));
+    chan_list_remove(&list, &self_p->socket);
+
+    if (chan_p == NULL) {
+        return (-MP_ETIMEDOUT);
+    }
+
+    return (0);
+}
+
+/**
+ * Raise OSError(EAGAIN) or OSError(ETIMEDOUT) if no data is
+ * available on given socket within its timeout.
+ */
+static void socket_wait_readable_raise(struct class_socket_t *self_p)
+{
+    int res;
+
+    res = module_socket_wait_readable(self_p);
+
+    if (res != 0) {
+        mp_raise_OSError(-res);
+    }
+}
+
 static mp_obj_t socket_make_new(const mp_obj_type_t *type_p,
                                 size_t n_args,
                                 size_t n_kw,
@@ -78,6 +131,8 @@ static mp_obj_t socket_make_new(const mp_obj_type_t *type_p,
 
     socket_p = m_new_obj(struct class_socket_t);
     socket_p->base.type = &module_socket_class_socket;
+    socket_p->timeout_p = NULL;
+    memset(&socket_p->addresses, 0, sizeof(socket_p->addresses));
 
     switch (type) {
 
@@ -107,13 +162,21 @@ static mp_obj_t class_socket_accept(mp_obj_t self_in)
     struct class_socket_t *self_p;
     struct class_socket_t *socket_p;
     mp_obj_tuple_t *tuple_p;
+    int res;
 
     self_p = MP_OBJ_TO_PTR(self_in);
+    socket_wait_readable_raise(self_p);
 
     socket_p = m_new_obj(struct class_socket_t);
     socket_p->base.type = &module_socket_class_socket;
+    socket_p->timeout_p = NULL;
+    memset(&socket_p->addresses, 0, sizeof(socket_p->addresses));
 
-    if (socket_accept(&self_p->socket, &socket_p->socket, NULL) != 0) {
+    MODULE_THREAD_PARK(res = socket_accept(&self_p->socket,
+                                           &socket_p->socket,
+                                           NULL));
+
+    if (res != 0) {
         nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
                                            "socket accept failed"));
     }
@@ -209,8 +272,9 @@ static mp_obj_t class_socket_recv(mp_obj_t self_in,
     self_p = MP_OBJ_TO_PTR(self_in);
     size = mp_obj_get_int(bufsize_in);
 
+    socket_wait_readable_raise(self_p);
     vstr_init(&vstr, size);
-    size = socket_read(&self_p->socket, vstr.buf, size);
+    MODULE_THREAD_PARK(size = socket_read(&self_p->socket, vstr.buf, size));
 
     if (size < 0) {
         size = 0;
@@ -221,28 +285,113 @@ static mp_obj_t class_socket_recv(mp_obj_t self_in,
     return (mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr));
 }
 
+/**
+ * Convert given Simba address to a Python address tuple (ip, port).
+ */
+static mp_obj_t address_to_tuple(struct inet_addr_t *address_p)
+{
+    vstr_t vstr;
+    mp_obj_tuple_t *tuple_p;
+
+    /* Convert the remote address IP to a vstr. */
+    vstr_init(&vstr, 20);
+
+    if (inet_ntoa(&address_p->ip, vstr.buf) == NULL) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
+                                           "socket recvfrom failed"));
+    }
+
+    vstr.len = strlen(vstr.buf);
+
+    /* Address tuple. */
+    tuple_p = MP_OBJ_TO_PTR(mp_obj_new_tuple(2, NULL));
+    tuple_p->items[0] = mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr);
+    tuple_p->items[1] = mp_obj_new_int(address_p->port);
+
+    return (MP_OBJ_FROM_PTR(tuple_p));
+}
+
+/**
+ * Returns the address tuple of given sender address. The last few
+ * senders are cached per socket, so datagrams from the same sender
+ * share one tuple and no memory is allocated.
+ */
+static mp_obj_t socket_address_tuple(struct class_socket_t *self_p,
+                                     struct inet_addr_t *address_p)
+{
+    struct class_socket_address_t *entry_p;
+    int i;
+
+    for (i = 0; i < membersof(self_p->addresses.entries); i++) {
+        entry_p = &self_p->addresses.entries[i];
+
+        if ((entry_p->tuple != MP_OBJ_NULL)
+            && (entry_p->address.port == address_p->port)
+            && (memcmp(&entry_p->address.ip,
+                       &address_p->ip,
+                       sizeof(address_p->ip)) == 0)) {
+            return (entry_p->tuple);
+        }
+    }
+
+    /* Replace the oldest entry. */
+    entry_p = &self_p->addresses.entries[self_p->addresses.next];
+    entry_p->tuple = address_to_tuple(address_p);
+    entry_p->address = *address_p;
+    self_p->addresses.next++;
+    self_p->addresses.next %= membersof(self_p->addresses.entries);
+
+    return (entry_p->tuple);
+}
+
+/**
+ * Get the caller supplied buffer of recv_into() and
+ * recvfrom_into(). The optional nbytes argument limits the number of
+ * bytes to receive.
+ */
+static void get_into_buffer(size_t n_args,
+                            const mp_obj_t *args_p,
+                            mp_buffer_info_t *buffer_info_p)
+{
+    mp_int_t nbytes;
+
+    mp_get_buffer_raise(args_p[1], buffer_info_p, MP_BUFFER_WRITE);
+
+    if (n_args == 3) {
+        nbytes = mp_obj_get_int(args_p[2]);
+
+        if (nbytes < 0) {
+            nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+                                               "negative buffersize"));
+        }
+
+        if ((nbytes > 0) && ((size_t)nbytes < buffer_info_p->len)) {
+            buffer_info_p->len = nbytes;
+        }
+    }
+}
+
 static mp_obj_t class_socket_recvfrom(mp_obj_t self_in,
                                       mp_obj_t bufsize_in)
 {
     struct class_socket_t *self_p;
     vstr_t vstr;
     ssize_t size;
-    vstr_t vstr_remote_address;
     struct inet_addr_t remote_address;
     mp_obj_tuple_t *tuple_p;
-    mp_obj_tuple_t *address_tuple_p;
 
     self_p = MP_OBJ_TO_PTR(self_in);
     size = mp_obj_get_int(bufsize_in);
 
     /* Read the data from the socket. */
+    socket_wait_readable_raise(self_p);
     vstr_init(&vstr, size);
 
-    size = socket_recvfrom(&self_p->socket,
-                           vstr.buf,
-                           size,
-                           0,
-                           &remote_address);
+    MODULE_THREAD_PARK(size = socket_recvfrom(&self_p->socket,
+                                              vstr.buf,
+                                              size,
+                                              0,
+                                              &remote_address));
 
     if (size < 0) {
         nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
@@ -251,42 +400,149 @@ static mp_obj_t class_socket_recvfrom(mp_obj_t self_in,
 
     vstr.len = size;
 
-    /* Convert the remote address IP to a vstr. */
-    vstr_init(&vstr_remote_address, 20);
+    /* Return tuple. */
+    tuple_p = MP_OBJ_TO_PTR(mp_obj_new_tuple(2, NULL));
+    tuple_p->items[0] = mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr);
+    tuple_p->items[1] = socket_address_tuple(self_p, &remote_address);
 
-    if (inet_ntoa(&remote_address.ip, vstr_remote_address.buf) == NULL) {
-        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
-                                           "socket recvfrom failed"));
+    return (MP_OBJ_FROM_PTR(tuple_p));
+}
+
+/**
+ * def recv_into(self, buffer[, nbytes])
+ *
+ * Receive data into given buffer without allocating any memory on
+ * the heap.
+ */
+static mp_obj_t class_socket_recv_into(size_t n_args, const mp_obj_t *args_p)
+{
+    struct class_socket_t *self_p;
+    mp_buffer_info_t buffer_info;
+    ssize_t size;
+
+    self_p = MP_OBJ_TO_PTR(args_p[0]);
+    get_into_buffer(n_args, args_p, &buffer_info);
+    socket_wait_readable_raise(self_p);
+
+    MODULE_THREAD_PARK(size = socket_read(&self_p->socket,
+                                          buffer_info.buf,
+                                          buffer_info.len));
+
+    if (size < 0) {
+        size = 0;
     }
 
-    vstr_remote_address.len = strlen(vstr_remote_address.buf);
+    return (MP_OBJ_NEW_SMALL_INT(size));
+}
 
-    /* Address tuple. */
-    address_tuple_p = MP_OBJ_TO_PTR(mp_obj_new_tuple(2, NULL));
-    address_tuple_p->items[0] = mp_obj_new_str_from_vstr(&mp_type_bytes,
-                                                         &vstr_remote_address);
-    address_tuple_p->items[1] = mp_obj_new_int(remote_address.port);
+/**
+ * def recvfrom_into(self, buffer[, nbytes])
+ *
+ * Receive a datagram into given buffer. Returns a tuple of the number
+ * of received bytes and the cached address tuple of the sender.
+ */
+static mp_obj_t class_socket_recvfrom_into(size_t n_args,
+                                           const mp_obj_t *args_p)
+{
+    struct class_socket_t *self_p;
+    mp_buffer_info_t buffer_info;
+    ssize_t size;
+    struct inet_addr_t remote_address;
+    mp_obj_tuple_t *tuple_p;
+
+    self_p = MP_OBJ_TO_PTR(args_p[0]);
+    get_into_buffer(n_args, args_p, &buffer_info);
+    socket_wait_readable_raise(self_p);
+
+    MODULE_THREAD_PARK(size = socket_recvfrom(&self_p->socket,
+                                              buffer_info.buf,
+                                              buffer_info.len,
+                                              0,
+                                              &remote_address));
+
+    if (size < 0) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
+                                           "socket recvfrom failed"));
+    }
 
     /* Return tuple. */
     tuple_p = MP_OBJ_TO_PTR(mp_obj_new_tuple(2, NULL));
-    tuple_p->items[0] = mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr);
-    tuple_p->items[1] = MP_OBJ_FROM_PTR(address_tuple_p);
+    tuple_p->items[0] = MP_OBJ_NEW_SMALL_INT(size);
+    tuple_p->items[1] = socket_address_tuple(self_p, &remote_address);
 
     return (MP_OBJ_FROM_PTR(tuple_p));
 }
 
-static mp_obj_t class_socket_recv_into(mp_obj_t self_in)
+/**
+ * def recvmmsg(self, buffers, sizes, addresses)
+ *
+ * Receive up to one datagram into each buffer in given list in a
+ * single call. The size and sender address tuple of each datagram
+ * are stored in the sizes and addresses lists, which must be at least
+ * as long as the buffers list. Waits for the first datagram within
+ * the socket timeout, then only receives datagrams that are already
+ * available. Returns the number of received datagrams.
+ */
+static mp_obj_t class_socket_recvmmsg(size_t n_args, const mp_obj_t *args_p)
 {
-    mp_not_implemented("socket.recv_into");
+    struct class_socket_t *self_p;
+    mp_buffer_info_t buffer_info;
+    struct inet_addr_t remote_address;
+    mp_obj_t *buffers_p;
+    mp_obj_t *sizes_p;
+    mp_obj_t *addresses_p;
+    size_t length;
+    size_t sizes_length;
+    size_t addresses_length;
+    ssize_t size;
+    size_t i;
 
-    return (mp_const_none);
-}
+    self_p = MP_OBJ_TO_PTR(args_p[0]);
 
-static mp_obj_t class_socket_recvfrom_into(mp_obj_t self_in)
-{
-    mp_not_implemented("socket.recvfrom_into");
+    if (!MP_OBJ_IS_TYPE(args_p[2], &mp_type_list)
+        || !MP_OBJ_IS_TYPE(args_p[3], &mp_type_list)) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_TypeError,
+                                           "sizes and addresses must be lists"));
+    }
 
-    return (mp_const_none);
+    mp_obj_get_array(args_p[1], &length, &buffers_p);
+    mp_obj_list_get(args_p[2], &sizes_length, &sizes_p);
+    mp_obj_list_get(args_p[3], &addresses_length, &addresses_p);
+
+    if ((sizes_length < length) || (addresses_length < length)) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+                                           "lists too short"));
+    }
+
+    for (i = 0; i < length; i++) {
+        if (i == 0) {
+            socket_wait_readable_raise(self_p);
+        } else if (chan_size(&self_p->socket) <= 0) {
+            break;
+        }
+
+        mp_get_buffer_raise(buffers_p[i], &buffer_info, MP_BUFFER_WRITE);
+
+        MODULE_THREAD_PARK(size = socket_recvfrom(&self_p->socket,
+                                                  buffer_info.buf,
+                                                  buffer_info.len,
+                                                  0,
+                                                  &remote_address));
+
+        if (size < 0) {
+            if (i == 0) {
+                nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
+                                                   "socket recvfrom failed"));
+            }
+
+            break;
+        }
+
+        sizes_p[i] = MP_OBJ_NEW_SMALL_INT(size);
+        addresses_p[i] = socket_address_tuple(self_p, &remote_address);
+    }
+
+    return (MP_OBJ_NEW_SMALL_INT(i));
 }
 
 static mp_obj_t class_socket_send(mp_obj_t self_in, mp_obj_t string_in)
@@ -309,10 +565,94 @@ static mp_obj_t class_socket_send(mp_obj_t self_in, mp_obj_t string_in)
     return (mp_obj_new_int(size));
 }
 
+/**
+ * Write all data in given buffer to the socket. A single socket
+ * write may write fewer bytes than requested, so keep writing until
+ * the whole buffer is written. Returns zero(0) on success, otherwise
+ * negative error code.
+ */
+static int socket_write_all(struct socket_t *socket_p,
+                            const void *buf_p,
+                            size_t size)
+{
+    const uint8_t *u8_buf_p;
+    ssize_t res;
+
+    u8_buf_p = buf_p;
+
+    while (size > 0) {
+        res = socket_write(socket_p, u8_buf_p, size);
+
+        if (res <= 0) {
+            return (-1);
+        }
+
+        u8_buf_p += res;
+        size -= res;
+    }
+
+    return (0);
+}
+
+/**
+ * def sendall(self, string)
+ */
 static mp_obj_t class_socket_sendall(mp_obj_t self_in,
                                      mp_obj_t string_in)
 {
-    return (class_socket_send(self_in, string_in));
+    struct class_socket_t *self_p;
+    mp_buffer_info_t buffer_info;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+    mp_get_buffer_raise(MP_OBJ_TO_PTR(string_in),
+                        &buffer_info,
+                        MP_BUFFER_READ);
+
+    if (socket_write_all(&self_p->socket,
+                         buffer_info.buf,
+                         buffer_info.len) != 0) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
+                                           "socket sendall failed"));
+    }
+
+    return (mp_obj_new_int(buffer_info.len));
+}
+
+/**
+ * def sendv(self, buffers)
+ *
+ * Write all data in given list or tuple of buffers to the socket
+ * without joining them into a new object. Returns the total number
+ * of written bytes.
+ */
+static mp_obj_t class_socket_sendv(mp_obj_t self_in,
+                                   mp_obj_t buffers_in)
+{
+    struct class_socket_t *self_p;
+    mp_buffer_info_t buffer_info;
+    mp_obj_t *items_p;
+    mp_uint_t len;
+    mp_uint_t i;
+    size_t size;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+    mp_obj_get_array(buffers_in, &len, &items_p);
+    size = 0;
+
+    for (i = 0; i < len; i++) {
+        mp_get_buffer_raise(items_p[i], &buffer_info, MP_BUFFER_READ);
+
+        if (socket_write_all(&self_p->socket,
+                             buffer_info.buf,
+                             buffer_info.len) != 0) {
+            nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
+                                               "socket sendv failed"));
+        }
+
+        size += buffer_info.len;
+    }
+
+    return (mp_obj_new_int(size));
 }
 
 static mp_obj_t class_socket_sendto(mp_obj_t self_in,
@@ -350,6 +690,60 @@ static mp_obj_t class_socket_sendto(mp_obj_t self_in,
     return (mp_obj_new_int(size));
 }
 
+/**
+ * def settimeout(self, value)
+ *
+ * Set a timeout on blocking socket operations. None makes the socket
+ * blocking and zero makes it non-blocking.
+ */
+static mp_obj_t class_socket_settimeout(mp_obj_t self_in,
+                                        mp_obj_t value_in)
+{
+    struct class_socket_t *self_p;
+    float f_timeout;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+
+    if (value_in == mp_const_none) {
+        self_p->timeout_p = NULL;
+    } else {
+        f_timeout = mp_obj_get_float(value_in);
+
+        if (f_timeout < 0) {
+            nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+                                               "timeout value out of range"));
+        }
+
+        self_p->timeout.seconds = (long)f_timeout;
+        self_p->timeout.nanoseconds =
+            (f_timeout - self_p->timeout.seconds) * 1000000000L;
+        self_p->timeout_p = &self_p->timeout;
+    }
+
+    return (mp_const_none);
+}
+
+/**
+ * def setblocking(self, flag)
+ */
+static mp_obj_t class_socket_setblocking(mp_obj_t self_in,
+                                         mp_obj_t flag_in)
+{
+    struct class_socket_t *self_p;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+
+    if (mp_obj_is_true(flag_in)) {
+        self_p->timeout_p = NULL;
+    } else {
+        self_p->timeout.seconds = 0;
+        self_p->timeout.nanoseconds = 0;
+        self_p->timeout_p = &self_p->timeout;
+    }
+
+    return (mp_const_none);
+}
+
 static mp_obj_t class_socket_shutdown(mp_obj_t self_in)
 {
     mp_not_implemented("socket.shutdown");
@@ -357,6 +751,54 @@ static mp_obj_t class_socket_shutdown(mp_obj_t self_in)
     return (mp_const_none);
 }
 
+static mp_uint_t class_socket_stream_read(mp_obj_t self_in,
+                                          void *buf_p,
+                                          mp_uint_t size,
+                                          int *errcode_p)
+{
+    struct class_socket_t *self_p;
+    ssize_t res;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+    res = module_socket_wait_readable(self_p);
+
+    if (res != 0) {
+        *errcode_p = -res;
+
+        return (MP_STREAM_ERROR);
+    }
+
+    MODULE_THREAD_PARK(res = socket_read(&self_p->socket, buf_p, size));
+
+    if (res < 0) {
+        *errcode_p = -res;
+
+        return (MP_STREAM_ERROR);
+    }
+
+    return (res);
+}
+
+static mp_uint_t class_socket_stream_write(mp_obj_t self_in,
+                                           const void *buf_p,
+                                           mp_uint_t size,
+                                           int *errcode_p)
+{
+    struct class_socket_t *self_p;
+    ssize_t res;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+    res = socket_write(&self_p->socket, buf_p, size);
+
+    if (res < 0) {
+        *errcode_p = -res;
+
+        return (MP_STREAM_ERROR);
+    }
+
+    return (res);
+}
+
 static MP_DEFINE_CONST_FUN_OBJ_1(socket_accept_obj, class_socket_accept);
 static MP_DEFINE_CONST_FUN_OBJ_2(socket_bind_obj, class_socket_bind);
 static MP_DEFINE_CONST_FUN_OBJ_1(socket_close_obj, class_socket_close);
@@ -364,11 +806,15 @@ static MP_DEFINE_CONST_FUN_OBJ_2(socket_connect_obj, class_socket_connect);
 static MP_DEFINE_CONST_FUN_OBJ_2(socket_listen_obj, class_socket_listen);
 static MP_DEFINE_CONST_FUN_OBJ_2(socket_recv_obj, class_socket_recv);
 static MP_DEFINE_CONST_FUN_OBJ_2(socket_recvfrom_obj, class_socket_recvfrom);
-static MP_DEFINE_CONST_FUN_OBJ_1(socket_recv_into_obj, class_socket_recv_into);
-static MP_DEFINE_CONST_FUN_OBJ_1(socket_recvfrom_into_obj, class_socket_recvfrom_into);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(socket_recv_into_obj, 2, 3, class_socket_recv_into);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(socket_recvfrom_into_obj, 2, 3, class_socket_recvfrom_into);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(socket_recvmmsg_obj, 4, 4, class_socket_recvmmsg);
 static MP_DEFINE_CONST_FUN_OBJ_2(socket_send_obj, class_socket_send);
 static MP_DEFINE_CONST_FUN_OBJ_2(socket_sendall_obj, class_socket_sendall);
+static MP_DEFINE_CONST_FUN_OBJ_2(socket_sendv_obj, class_socket_sendv);
 static MP_DEFINE_CONST_FUN_OBJ_3(socket_sendto_obj, class_socket_sendto);
+static MP_DEFINE_CONST_FUN_OBJ_2(socket_setblocking_obj, class_socket_setblocking);
+static MP_DEFINE_CONST_FUN_OBJ_2(socket_settimeout_obj, class_socket_settimeout);
 static MP_DEFINE_CONST_FUN_OBJ_1(socket_shutdown_obj, class_socket_shutdown);
 
 static const mp_rom_map_elem_t class_socket_locals_dict_table[] = {
@@ -381,14 +827,32 @@ static const mp_rom_map_elem_t class_socket_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_recvfrom), MP_ROM_PTR(&socket_recvfrom_obj) },
     { MP_ROM_QSTR(MP_QSTR_recv_into), MP_ROM_PTR(&socket_recv_into_obj) },
     { MP_ROM_QSTR(MP_QSTR_recvfrom_into), MP_ROM_PTR(&socket_recvfrom_into_obj) },
+    { MP_ROM_QSTR(MP_QSTR_recvmmsg), MP_ROM_PTR(&socket_recvmmsg_obj) },
     { MP_ROM_QSTR(MP_QSTR_send), MP_ROM_PTR(&socket_send_obj) },
     { MP_ROM_QSTR(MP_QSTR_sendall), MP_ROM_PTR(&socket_sendall_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sendv), MP_ROM_PTR(&socket_sendv_obj) },
     { MP_ROM_QSTR(MP_QSTR_sendto), MP_ROM_PTR(&socket_sendto_obj) },
-    { MP_ROM_QSTR(MP_QSTR_shutdown), MP_ROM_PTR(&socket_shutdown_obj) }
+    { MP_ROM_QSTR(MP_QSTR_setblocking), MP_ROM_PTR(&socket_setblocking_obj) },
+    { MP_ROM_QSTR(MP_QSTR_settimeout), MP_ROM_PTR(&socket_settimeout_obj) },
+    { MP_ROM_QSTR(MP_QSTR_shutdown), MP_ROM_PTR(&socket_shutdown_obj) },
+
+    /* Stream protocol. */
+    { MP_ROM_QSTR(MP_QSTR_read), MP_ROM_PTR(&mp_stream_read_obj) },
+    { MP_ROM_QSTR(MP_QSTR_readinto), MP_ROM_PTR(&mp_stream_readinto_obj) },
+    { MP_ROM_QSTR(MP_QSTR_readline), MP_ROM_PTR(&mp_stream_unbuffered_readline_obj) },
+    { MP_ROM_QSTR(MP_QSTR_write), MP_ROM_PTR(&mp_stream_write_obj) }
 };
 
 static MP_DEFINE_CONST_DICT(class_socket_locals_dict, class_socket_locals_dict_table);
 
+/**
+ * The socket stream.
+ */
+static const mp_stream_p_t class_socket_stream = {
+    .read = class_socket_stream_read,
+    .write = class_socket_stream_write,
+};
+
 /**
  * The socket class.
  */
@@ -396,6 +860,7 @@ const mp_obj_type_t module_socket_class_socket = {
     { &mp_type_type },
     .name = MP_QSTR_SocketType,
     .make_new = socket_make_new,
+    .protocol = &class_socket_stream,
     .locals_dict = (void*)&class_socket_locals_dict,
 };
 
@@ -32,6 +32,23 @@
 
 #if CONFIG_PUMBAA_MODULE_SSL == 1
 
+#if CONFIG_PUMBAA_SSL_SESSION_CACHE == 1
+#    include "mbedtls/ssl.h"
+#endif
+
+#if CONFIG_PUMBAA_SSL_LOW_RAM == 1
+#    include "mbedtls/ssl.h"
+#    include "mbedtls/ssl_internal.h"
+#    include "mbedtls/x509_crt.h"
+#    include "mbedtls/pk.h"
+#endif
+
+#if CONFIG_PUMBAA_SSL_LOW_RAM == 1
+#    if MBEDTLS_SSL_MAX_CONTENT_LEN < CONFIG_PUMBAA_SSL_MAX_FRAGMENT_LENGTH
+#        error "MBEDTLS_SSL_MAX_CONTENT_LEN is less than CONFIG_PUMBAA_SSL_MAX_FRAGMENT_LENGTH."
+#    endif
+#endif
+
 extern const mp_obj_type_t module_socket_class_socket;
 extern const mp_obj_type_t module_ssl_class_ssl_context;
 extern const mp_obj_type_t module_ssl_class_ssl_socket;
@@ -66,6 +83,472 @@ const char *read_file(const char *path_p)
     return (buf_p);
 }
 
+#if CONFIG_PUMBAA_SSL_LOW_RAM == 1
+
+/**
+ * A parsed certificate chain or private key, shared by all contexts
+ * loading the same file. The file size is stored to detect changed
+ * files, as Simba's fs_stat() has no mtime. An entry used by a context
+ * is never freed, as mbedtls keeps pointers to it in the context
+ * configuration and contexts have no finaliser. An entry in use stays
+ * in the cache until its file changes size, after which it is retired
+ * with an empty path and its slot is never reused.
+ */
+struct cert_cache_entry_t {
+    char path[64];
+    unsigned long size;
+    int is_key;
+    int in_use;
+    int parsed;
+    union {
+        mbedtls_x509_crt crt;
+        mbedtls_pk_context pk;
+    } u;
+};
+
+/**
+ * The cache is accessed by threads that do not hold the GIL, so the
+ * table is protected by a semaphore.
+ */
+struct cert_cache_t {
+    struct sem_t sem;
+    struct cert_cache_entry_t entries[CONFIG_PUMBAA_SSL_CERT_CACHE_MAX];
+};
+
+static struct cert_cache_t cert_cache;
+
+/**
+ * Remove given entry from the cache, so that its file is parsed again
+ * on next use. The parsed data is freed unless it is used by a
+ * context.
+ */
+static void cert_cache_retire(struct cert_cache_entry_t *entry_p)
+{
+    entry_p->path[0] = '\0';
+
+    if (entry_p->in_use == 1) {
+        return;
+    }
+
+    if (entry_p->is_key == 1) {
+        mbedtls_pk_free(&entry_p->u.pk);
+    } else {
+        mbedtls_x509_crt_free(&entry_p->u.crt);
+    }
+
+    entry_p->parsed = 0;
+}
+
+/**
+ * Get the parsed certificate chain or private key in given file,
+ * parsing it if not already cached or if the file size has
+ * changed. Returns NULL if the file could not be parsed or the cache
+ * is full. The cache semaphore must be taken by the caller.
+ */
+static struct cert_cache_entry_t *cert_cache_get(const char *path_p,
+                                                 int is_key)
+{
+    struct cert_cache_entry_t *entry_p;
+    struct fs_stat_t stat;
+    const char *buf_p;
+    int res;
+    int i;
+
+    if ((strlen(path_p) >= sizeof(entry_p->path))
+        || (fs_stat(path_p, &stat) != 0)) {
+        return (NULL);
+    }
+
+    for (i = 0; i < membersof(cert_cache.entries); i++) {
+        entry_p = &cert_cache.entries[i];
+
+        if ((entry_p->parsed == 1)
+            && (entry_p->is_key == is_key)
+            && (strcmp(&entry_p->path[0], path_p) == 0)) {
+            if (entry_p->size == stat.size) {
+                return (entry_p);
+            }
+
+            cert_cache_retire(entry_p);
+        }
+    }
+
+    for (i = 0; i < membersof(cert_cache.entries); i++) {
+        if (cert_cache.entries[i].parsed == 0) {
+            break;
+        }
+    }
+
+    if (i == membersof(cert_cache.entries)) {
+        return (NULL);
+    }
+
+    buf_p = read_file(path_p);
+
+    if (buf_p == NULL) {
+        return (NULL);
+    }
+
+    /* The PEM data is only needed while parsing, so it is left to the
+       garbage collector. */
+    entry_p = &cert_cache.entries[i];
+
+    if (is_key == 1) {
+        mbedtls_pk_init(&entry_p->u.pk);
+        res = mbedtls_pk_parse_key(&entry_p->u.pk,
+                                   (const unsigned char *)buf_p,
+                                   strlen(buf_p) + 1,
+                                   NULL,
+                                   0);
+
+        if (res != 0) {
+            mbedtls_pk_free(&entry_p->u.pk);
+        }
+    } else {
+        mbedtls_x509_crt_init(&entry_p->u.crt);
+        res = mbedtls_x509_crt_parse(&entry_p->u.crt,
+                                     (const unsigned char *)buf_p,
+                                     strlen(buf_p) + 1);
+
+        if (res != 0) {
+            mbedtls_x509_crt_free(&entry_p->u.crt);
+        }
+    }
+
+    if (res != 0) {
+        return (NULL);
+    }
+
+    strcpy(&entry_p->path[0], path_p);
+    entry_p->size = stat.size;
+    entry_p->is_key = is_key;
+    entry_p->in_use = 0;
+    entry_p->parsed = 1;
+
+    return (entry_p);
+}
+
+/**
+ * Use the shared certificate chain and private key in given files as
+ * the own certificate of given context. The key is read from the
+ * certificate file if no key file is given. Returns zero(0) on
+ * success, otherwise negative error code.
+ */
+static int cert_cache_load_cert_chain(struct class_ssl_context_t *self_p,
+                                      const char *certfile_p,
+                                      const char *keyfile_p)
+{
+    struct cert_cache_entry_t *cert_p;
+    struct cert_cache_entry_t *key_p;
+    int res;
+
+    if (keyfile_p == NULL) {
+        keyfile_p = certfile_p;
+    }
+
+    res = -1;
+    sem_take(&cert_cache.sem, NULL);
+    cert_p = cert_cache_get(certfile_p, 0);
+
+    if (cert_p != NULL) {
+        key_p = cert_cache_get(keyfile_p, 1);
+
+        if ((key_p != NULL)
+            && (mbedtls_ssl_conf_own_cert(self_p->context.conf_p,
+                                          &cert_p->u.crt,
+                                          &key_p->u.pk) == 0)) {
+            cert_p->in_use = 1;
+            key_p->in_use = 1;
+            res = 0;
+        }
+    }
+
+    sem_give(&cert_cache.sem, 1);
+
+    return (res);
+}
+
+/**
+ * Use the shared CA certificate chain in given file to verify the
+ * peer of given context. Returns zero(0) on success, otherwise
+ * negative error code.
+ */
+static int cert_cache_load_verify_location(struct class_ssl_context_t *self_p,
+                                           const char *cafile_p)
+{
+    struct cert_cache_entry_t *ca_p;
+    int res;
+
+    res = -1;
+    sem_take(&cert_cache.sem, NULL);
+    ca_p = cert_cache_get(cafile_p, 0);
+
+    if (ca_p != NULL) {
+        mbedtls_ssl_conf_ca_chain(self_p->context.conf_p, &ca_p->u.crt, NULL);
+        ca_p->in_use = 1;
+        res = 0;
+    }
+
+    sem_give(&cert_cache.sem, 1);
+
+    return (res);
+}
+
+/**
+ * Returns the mbedtls code of given maximum fragment length, or -1 if
+ * not supported.
+ */
+static int max_fragment_length_code(int length)
+{
+    switch (length) {
+
+    case 0:
+        return (MBEDTLS_SSL_MAX_FRAG_LEN_NONE);
+
+    case 512:
+        return (MBEDTLS_SSL_MAX_FRAG_LEN_512);
+
+    case 1024:
+        return (MBEDTLS_SSL_MAX_FRAG_LEN_1024);
+
+    case 2048:
+        return (MBEDTLS_SSL_MAX_FRAG_LEN_2048);
+
+    case 4096:
+        return (MBEDTLS_SSL_MAX_FRAG_LEN_4096);
+
+    default:
+        return (-1);
+    }
+}
+
+#endif
+
+#if CONFIG_PUMBAA_SSL_SESSION_CACHE == 1
+
+#define SESSION_CACHE_FILE_MAGIC                        0x53534331
+
+/* 2017-01-01 in seconds since the epoch. An earlier system time is
+   time since startup rather than wall clock time. */
+#define SESSION_CACHE_WALL_CLOCK_MIN                    1483228800L
+
+/**
+ * A cached session. Only plain data is stored, so entries can be
+ * written to and read from a file as is.
+ */
+struct session_cache_entry_t {
+    long timestamp;
+    int ciphersuite;
+    int compression;
+    uint32_t verify_result;
+    size_t id_len;
+    unsigned char id[32];
+    unsigned char master[48];
+};
+
+/**
+ * A bounded session cache. It is accessed from the mbedtls handshake,
+ * which may run in threads that do not hold the GIL, so it must not
+ * use any Python objects.
+ */
+struct class_ssl_session_cache_t {
+    struct sem_t sem;
+    struct session_cache_entry_t *entries_p;
+    int size;
+    long timeout;
+    char path[64];
+    unsigned long hits;
+    unsigned long misses;
+};
+
+static int session_cache_is_expired(struct class_ssl_session_cache_t *self_p,
+                                    struct session_cache_entry_t *entry_p,
+                                    long now)
+{
+    return ((entry_p->id_len == 0)
+            || ((self_p->timeout > 0)
+                && (now - entry_p->timestamp > self_p->timeout)));
+}
+
+/**
+ * Read the cached sessions from the cache file, if any. The age of a
+ * loaded session is only known if both its timestamp and the current
+ * system time are wall clock time, for example set by SNTP. All other
+ * sessions are dropped, as they may have been saved before a
+ * restart.
+ */
+static void session_cache_load(struct class_ssl_session_cache_t *self_p)
+{
+    struct fs_file_t file;
+    struct time_t now;
+    uint32_t header[2];
+    size_t size;
+    int i;
+
+    if (fs_open(&file, &self_p->path[0], FS_READ) != 0) {
+        return;
+    }
+
+    if ((fs_read(&file, &header[0], sizeof(header)) == sizeof(header))
+        && (header[0] == SESSION_CACHE_FILE_MAGIC)) {
+        size = (MIN(header[1], self_p->size) * sizeof(*self_p->entries_p));
+
+        if (fs_read(&file, self_p->entries_p, size) != size) {
+            memset(self_p->entries_p, 0, size);
+        }
+    }
+
+    fs_close(&file);
+
+    time_get(&now);
+
+    for (i = 0; i < self_p->size; i++) {
+        if ((now.seconds < SESSION_CACHE_WALL_CLOCK_MIN)
+            || (self_p->entries_p[i].timestamp < SESSION_CACHE_WALL_CLOCK_MIN)
+            || (self_p->entries_p[i].timestamp > now.seconds)) {
+            memset(&self_p->entries_p[i], 0, sizeof(self_p->entries_p[i]));
+        }
+    }
+}
+
+/**
+ * Write all cached sessions to the cache file. Returns zero(0) or
+ * negative error code.
+ */
+static int session_cache_save(struct class_ssl_session_cache_t *self_p)
+{
+    struct fs_file_t file;
+    uint32_t header[2];
+    size_t size;
+    int res;
+
+    if (fs_open(&file,
+                &self_p->path[0],
+                FS_WRITE | FS_CREAT | FS_TRUNC) != 0) {
+        return (-EIO);
+    }
+
+    header[0] = SESSION_CACHE_FILE_MAGIC;
+    header[1] = self_p->size;
+    size = (self_p->size * sizeof(*self_p->entries_p));
+    res = -EIO;
+
+    if ((fs_write(&file, &header[0], sizeof(header)) == sizeof(header))
+        && (fs_write(&file, self_p->entries_p, size) == size)) {
+        res = 0;
+    }
+
+    fs_close(&file);
+
+    return (res);
+}
+
+/**
+ * Get the session with the id of given session from the cache. Called
+ * by mbedtls when a client tries to resume a session. Returns zero if
+ * the session was found.
+ */
+static int session_cache_get(void *arg_p, mbedtls_ssl_session *session_p)
+{
+    struct class_ssl_session_cache_t *self_p;
+    struct session_cache_entry_t *entry_p;
+    struct time_t now;
+    int res;
+    int i;
+
+    self_p = arg_p;
+    time_get(&now);
+    res = 1;
+
+    sem_take(&self_p->sem, NULL);
+
+    for (i = 0; i < self_p->size; i++) {
+        entry_p = &self_p->entries_p[i];
+
+        if (session_cache_is_expired(self_p, entry_p, now.seconds)) {
+            continue;
+        }
+
+        if ((session_p->ciphersuite != entry_p->ciphersuite)
+            || (session_p->compression != entry_p->compression)
+            || (session_p->id_len != entry_p->id_len)
+            || (memcmp(session_p->id, entry_p->id, entry_p->id_len) != 0)) {
+            continue;
+        }
+
+        memcpy(session_p->master, entry_p->master, sizeof(entry_p->master));
+        session_p->verify_result = entry_p->verify_result;
+        res = 0;
+        break;
+    }
+
+    if (res == 0) {
+        self_p->hits++;
+    } else {
+        self_p->misses++;
+    }
+
+    sem_give(&self_p->sem, 1);
+
+    return (res);
+}
+
+/**
+ * Add given session to the cache, replacing an entry with the same
+ * id, an expired entry or the oldest entry. Called by mbedtls after a
+ * full handshake.
+ */
+static int session_cache_set(void *arg_p, const mbedtls_ssl_session *session_p)
+{
+    struct class_ssl_session_cache_t *self_p;
+    struct session_cache_entry_t *entry_p;
+    struct session_cache_entry_t *oldest_p;
+    struct time_t now;
+    int i;
+
+    self_p = arg_p;
+    time_get(&now);
+    oldest_p = NULL;
+
+    if (session_p->id_len > sizeof(entry_p->id)) {
+        return (1);
+    }
+
+    sem_take(&self_p->sem, NULL);
+
+    for (i = 0; i < self_p->size; i++) {
+        entry_p = &self_p->entries_p[i];
+
+        if ((entry_p->id_len == session_p->id_len)
+            && (memcmp(entry_p->id, session_p->id, entry_p->id_len) == 0)) {
+            oldest_p = entry_p;
+            break;
+        }
+
+        if (session_cache_is_expired(self_p, entry_p, now.seconds)) {
+            oldest_p = entry_p;
+        } else if ((oldest_p == NULL)
+                   || ((oldest_p->id_len != 0)
+                       && (entry_p->timestamp < oldest_p->timestamp))) {
+            oldest_p = entry_p;
+        }
+    }
+
+    oldest_p->timestamp = now.seconds;
+    oldest_p->ciphersuite = session_p->ciphersuite;
+    oldest_p->compression = session_p->compression;
+    oldest_p->verify_result = session_p->verify_result;
+    oldest_p->id_len = session_p->id_len;
+    memcpy(oldest_p->id, session_p->id, session_p->id_len);
+    memcpy(oldest_p->master, session_p->master, sizeof(oldest_p->master));
+
+    sem_give(&self_p->sem, 1);
+
+    return (0);
+}
+
+#endif
+
 static mp_obj_t class_ssl_context_make_new(const mp_obj_type_t *type_p,
                                            size_t n_args,
                                            size_t n_kw,
@@ -77,12 +560,20 @@ static mp_obj_t class_ssl_context_make_new(const mp_obj_type_t *type_p,
 
     self_p = m_new_obj(struct class_ssl_context_t);
     self_p->base.type = &module_ssl_class_ssl_context;
+    self_p->session_cache_p = NULL;
 
     if (ssl_context_init(&self_p->context, ssl_protocol_tls_v1_0) != 0) {
         nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
                                            "failed to create ssl context"));
     }
 
+#if CONFIG_PUMBAA_SSL_LOW_RAM == 1
+    /* Ask servers for small records. */
+    mbedtls_ssl_conf_max_frag_len(
+        self_p->context.conf_p,
+        max_fragment_length_code(CONFIG_PUMBAA_SSL_MAX_FRAGMENT_LENGTH));
+#endif
+
     return (self_p);
 }
 
@@ -110,6 +601,19 @@ static mp_obj_t class_ssl_context_load_cert_chain(size_t n_args,
                      args);
 
     self_p = MP_OBJ_TO_PTR(pos_args_p[0]);
+
+#if CONFIG_PUMBAA_SSL_LOW_RAM == 1
+    /* Share the parsed certificate chain and key with other contexts
+       if possible. */
+    if (cert_cache_load_cert_chain(self_p,
+                                   mp_obj_str_get_str(pos_args_p[1]),
+                                   (args[0].u_obj == mp_const_none
+                                    ? NULL
+                                    : mp_obj_str_get_str(args[0].u_obj))) == 0) {
+        return (mp_const_none);
+    }
+#endif
+
     mp_get_buffer_raise(MP_OBJ_TO_PTR(pos_args_p[1]),
                         &buffer_info,
                         MP_BUFFER_READ);
@@ -159,6 +663,15 @@ static mp_obj_t class_ssl_context_load_verify_locations(size_t n_args,
                      args);
 
     self_p = MP_OBJ_TO_PTR(pos_args_p[0]);
+
+#if CONFIG_PUMBAA_SSL_LOW_RAM == 1
+    if (cert_cache_load_verify_location(
+            self_p,
+            mp_obj_str_get_str(args[0].u_obj)) == 0) {
+        return (mp_const_none);
+    }
+#endif
+
     mp_get_buffer_raise(MP_OBJ_TO_PTR(args[0].u_obj),
                         &buffer_info,
                         MP_BUFFER_READ);
@@ -200,6 +713,190 @@ static mp_obj_t class_ssl_context_set_verify_mode(mp_obj_t self_in,
     return (mp_const_none);
 }
 
+/**
+ * def set_max_fragment_length(length)
+ *
+ * Negotiate given maximum record fragment length of 512, 1024, 2048
+ * or 4096 bytes with servers, or 0 to not negotiate it. Smaller
+ * records allow a build with smaller record buffers.
+ */
+static mp_obj_t class_ssl_context_set_max_fragment_length(mp_obj_t self_in,
+                                                          mp_obj_t length_in)
+{
+#if CONFIG_PUMBAA_SSL_LOW_RAM == 1
+    struct class_ssl_context_t *self_p;
+    int code;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+    code = max_fragment_length_code(mp_obj_get_int(length_in));
+
+    if (code == -1) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+                                           "bad fragment length"));
+    }
+
+    if (mbedtls_ssl_conf_max_frag_len(self_p->context.conf_p, code) != 0) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
+                                           "failed to set fragment length"));
+    }
+
+    return (mp_const_none);
+#else
+    mp_not_implemented("set_max_fragment_length");
+
+    return (mp_const_none);
+#endif
+}
+
+/**
+ * def set_session_cache(size, timeout=86400, path=None)
+ *
+ * Cache up to given number of server side sessions, so clients can
+ * resume them by session id. The sessions are read from given file
+ * when the cache is created, and written to it by
+ * save_session_cache(). Sessions are only read from the file if the
+ * system time is wall clock time, as their age is unknown
+ * otherwise. The file contains the session master secrets and must
+ * be protected accordingly.
+ */
+static mp_obj_t class_ssl_context_set_session_cache(size_t n_args,
+                                                    const mp_obj_t *pos_args_p,
+                                                    mp_map_t *kw_args_p)
+{
+#if CONFIG_PUMBAA_SSL_SESSION_CACHE == 1
+    struct class_ssl_context_t *self_p;
+    struct class_ssl_session_cache_t *cache_p;
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_size, MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_timeout, MP_ARG_INT, { .u_int = 86400 } },
+        { MP_QSTR_path, MP_ARG_OBJ, { .u_obj = mp_const_none } }
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    const char *path_p;
+
+    mp_arg_parse_all(n_args - 1,
+                     pos_args_p + 1,
+                     kw_args_p,
+                     MP_ARRAY_SIZE(allowed_args),
+                     allowed_args,
+                     args);
+
+    self_p = MP_OBJ_TO_PTR(pos_args_p[0]);
+
+    if (self_p->session_cache_p != NULL) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
+                                           "session cache already set"));
+    }
+
+    if (args[0].u_int < 1) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+                                           "bad session cache size"));
+    }
+
+    cache_p = m_new0(struct class_ssl_session_cache_t, 1);
+    cache_p->entries_p = m_new0(struct session_cache_entry_t, args[0].u_int);
+    cache_p->size = args[0].u_int;
+    cache_p->timeout = args[1].u_int;
+    sem_init(&cache_p->sem, 0, 1);
+
+    if (args[2].u_obj != mp_const_none) {
+        path_p = mp_obj_str_get_str(args[2].u_obj);
+
+        if (strlen(path_p) >= sizeof(cache_p->path)) {
+            nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+                                               "path too long"));
+        }
+
+        strcpy(&cache_p->path[0], path_p);
+        session_cache_load(cache_p);
+    }
+
+    self_p->session_cache_p = cache_p;
+    mbedtls_ssl_conf_session_cache(self_p->context.conf_p,
+                                   cache_p,
+                                   session_cache_get,
+                                   session_cache_set);
+
+    return (mp_const_none);
+#else
+    mp_not_implemented("set_session_cache");
+
+    return (mp_const_none);
+#endif
+}
+
+/**
+ * def save_session_cache()
+ *
+ * Write the cached sessions to the file given to
+ * set_session_cache(). Sessions are not written as they are added,
+ * as that would write the file on every full handshake.
+ */
+static mp_obj_t class_ssl_context_save_session_cache(mp_obj_t self_in)
+{
+#if CONFIG_PUMBAA_SSL_SESSION_CACHE == 1
+    struct class_ssl_context_t *self_p;
+    struct class_ssl_session_cache_t *cache_p;
+    int res;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+    cache_p = self_p->session_cache_p;
+
+    if ((cache_p == NULL) || (cache_p->path[0] == '\0')) {
+        nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
+                                           "no session cache file"));
+    }
+
+    sem_take(&cache_p->sem, NULL);
+    res = session_cache_save(cache_p);
+    sem_give(&cache_p->sem, 1);
+
+    if (res != 0) {
+        mp_raise_OSError(MP_EIO);
+    }
+
+    return (mp_const_none);
+#else
+    mp_not_implemented("save_session_cache");
+
+    return (mp_const_none);
+#endif
+}
+
+/**
+ * def session_cache_info()
+ *
+ * Returns a tuple of the number of resumed sessions and the number of
+ * resumption attempts that missed the cache.
+ */
+static mp_obj_t class_ssl_context_session_cache_info(mp_obj_t self_in)
+{
+    struct class_ssl_context_t *self_p;
+    mp_obj_t items[2];
+    unsigned long hits;
+    unsigned long misses;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+    hits = 0;
+    misses = 0;
+
+#if CONFIG_PUMBAA_SSL_SESSION_CACHE == 1
+    if (self_p->session_cache_p != NULL) {
+        sem_take(&self_p->session_cache_p->sem, NULL);
+        hits = self_p->session_cache_p->hits;
+        misses = self_p->session_cache_p->misses;
+        sem_give(&self_p->session_cache_p->sem, 1);
+    }
+#else
+    (void)self_p;
+#endif
+
+    items[0] = mp_obj_new_int_from_uint(hits);
+    items[1] = mp_obj_new_int_from_uint(misses);
+
+    return (mp_obj_new_tuple(2, items));
+}
+
 /**
  * def wrap_socket(sock, server_side=False)
  */
@@ -275,6 +972,15 @@ static MP_DEFINE_CONST_FUN_OBJ_2(class_ssl_context_set_verify_mode_obj,
 static MP_DEFINE_CONST_FUN_OBJ_KW(class_ssl_context_wrap_socket_obj,
                                   1,
                                   class_ssl_context_wrap_socket);
+static MP_DEFINE_CONST_FUN_OBJ_2(class_ssl_context_set_max_fragment_length_obj,
+                                 class_ssl_context_set_max_fragment_length);
+static MP_DEFINE_CONST_FUN_OBJ_KW(class_ssl_context_set_session_cache_obj,
+                                  2,
+                                  class_ssl_context_set_session_cache);
+static MP_DEFINE_CONST_FUN_OBJ_1(class_ssl_context_save_session_cache_obj,
+                                 class_ssl_context_save_session_cache);
+static MP_DEFINE_CONST_FUN_OBJ_1(class_ssl_context_session_cache_info_obj,
+                                 class_ssl_context_session_cache_info);
 
 static const mp_rom_map_elem_t class_ssl_context_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_load_cert_chain),
@@ -284,7 +990,15 @@ static const mp_rom_map_elem_t class_ssl_context_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_set_verify_mode),
       MP_ROM_PTR(&class_ssl_context_set_verify_mode_obj) },
     { MP_ROM_QSTR(MP_QSTR_wrap_socket),
-      MP_ROM_PTR(&class_ssl_context_wrap_socket_obj) }
+      MP_ROM_PTR(&class_ssl_context_wrap_socket_obj) },
+    { MP_ROM_QSTR(MP_QSTR_set_max_fragment_length),
+      MP_ROM_PTR(&class_ssl_context_set_max_fragment_length_obj) },
+    { MP_ROM_QSTR(MP_QSTR_set_session_cache),
+      MP_ROM_PTR(&class_ssl_context_set_session_cache_obj) },
+    { MP_ROM_QSTR(MP_QSTR_save_session_cache),
+      MP_ROM_PTR(&class_ssl_context_save_session_cache_obj) },
+    { MP_ROM_QSTR(MP_QSTR_session_cache_info),
+      MP_ROM_PTR(&class_ssl_context_session_cache_info_obj) }
 };
 
 static MP_DEFINE_CONST_DICT(class_ssl_context_locals_dict,
@@ -300,6 +1014,53 @@ const mp_obj_type_t module_ssl_class_ssl_context = {
     .locals_dict = (void*)&class_ssl_context_locals_dict,
 };
 
+/**
+ * Wait for data to become available on given SSL socket, using the
+ * timeout of the wrapped socket. Decrypted data may already be
+ * buffered in the SSL layer, in which case the wrapped socket has
+ * nothing more to read. Returns zero(0) if data is available,
+ * otherwise negative error code.
+ *
+ * Only the first byte of a record is waited for. The following read
+ * blocks until the rest of the record has been received, as the SSL
+ * layer cannot decrypt a partial record, so a non-blocking or timed
+ * out socket may block for up to a record transmission time.
+ */
+static int ssl_socket_wait_readable(struct class_ssl_socket_t *self_p)
+{
+    struct class_socket_t *sock_p;
+
+    sock_p = MP_OBJ_TO_PTR(self_p->sock_obj);
+
+    if (sock_p->timeout_p == NULL) {
+        return (0);
+    }
+
+    if (ssl_socket_size(&self_p->socket) > 0) {
+        return (0);
+    }
+
+    return (module_socket_wait_readable(sock_p));
+}
+
+static void ssl_socket_wait_readable_raise(struct class_ssl_socket_t *self_p)
+{
+    int res;
+
+    res = ssl_socket_wait_readable(self_p);
+
+    if (res != 0) {
+        mp_raise_OSError(-res);
+    }
+}
+
+/**
+ * def recv(self, bufsize)
+ *
+ * Receive decrypted data. The timeout of the wrapped socket only
+ * applies until the first byte of a record is received. The rest of
+ * the record is then waited for without a timeout.
+ */
 static mp_obj_t class_ssl_socket_recv(mp_obj_t self_in,
                                       mp_obj_t bufsize_in)
 {
@@ -310,8 +1071,12 @@ static mp_obj_t class_ssl_socket_recv(mp_obj_t self_in,
     self_p = MP_OBJ_TO_PTR(self_in);
     size = mp_obj_get_int(bufsize_in);
 
+    ssl_socket_wait_readable_raise(self_p);
     vstr_init(&vstr, size);
-    size = ssl_socket_read(&self_p->socket, vstr.buf, size);
+
+    MODULE_THREAD_PARK(size = ssl_socket_read(&self_p->socket,
+                                              vstr.buf,
+                                              size));
 
     if (size < 0) {
         size = 0;
@@ -322,6 +1087,50 @@ static mp_obj_t class_ssl_socket_recv(mp_obj_t self_in,
     return (mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr));
 }
 
+/**
+ * def recv_into(self, buffer[, nbytes])
+ *
+ * Receive decrypted data into given buffer without allocating any
+ * memory on the heap. Blocks for the rest of a partially received
+ * record, like recv().
+ */
+static mp_obj_t class_ssl_socket_recv_into(size_t n_args,
+                                           const mp_obj_t *args_p)
+{
+    struct class_ssl_socket_t *self_p;
+    mp_buffer_info_t buffer_info;
+    mp_int_t nbytes;
+    ssize_t size;
+
+    self_p = MP_OBJ_TO_PTR(args_p[0]);
+    mp_get_buffer_raise(args_p[1], &buffer_info, MP_BUFFER_WRITE);
+
+    if (n_args == 3) {
+        nbytes = mp_obj_get_int(args_p[2]);
+
+        if (nbytes < 0) {
+            nlr_raise(mp_obj_new_exception_msg(&mp_type_ValueError,
+                                               "negative buffersize"));
+        }
+
+        if ((nbytes > 0) && ((size_t)nbytes < buffer_info.len)) {
+            buffer_info.len = nbytes;
+        }
+    }
+
+    ssl_socket_wait_readable_raise(self_p);
+
+    MODULE_THREAD_PARK(size = ssl_socket_read(&self_p->socket,
+                                              buffer_info.buf,
+                                              buffer_info.len));
+
+    if (size < 0) {
+        size = 0;
+    }
+
+    return (MP_OBJ_NEW_SMALL_INT(size));
+}
+
 static mp_obj_t class_ssl_socket_send(mp_obj_t self_in, mp_obj_t string_in)
 {
     struct class_ssl_socket_t *self_p;
@@ -333,9 +1142,9 @@ static mp_obj_t class_ssl_socket_send(mp_obj_t self_in, mp_obj_t string_in)
                         &buffer_info,
                         MP_BUFFER_READ);
 
-    size = ssl_socket_write(&self_p->socket,
-                            buffer_info.buf,
-                            buffer_info.len);
+    MODULE_THREAD_PARK(size = ssl_socket_write(&self_p->socket,
+                                               buffer_info.buf,
+                                               buffer_info.len));
 
     if (size < 0) {
         nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
@@ -404,8 +1213,104 @@ static mp_obj_t class_ssl_socket_get_server_hostname(mp_obj_t self_in)
     }
 }
 
+/**
+ * def setblocking(self, flag)
+ *
+ * The SSL socket shares the blocking mode and timeout of the wrapped
+ * socket.
+ */
+static mp_obj_t class_ssl_socket_setblocking(mp_obj_t self_in,
+                                             mp_obj_t flag_in)
+{
+    struct class_ssl_socket_t *self_p;
+    mp_obj_t dest[3];
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+    mp_load_method(self_p->sock_obj, MP_QSTR_setblocking, dest);
+    dest[2] = flag_in;
+
+    return (mp_call_method_n_kw(1, 0, dest));
+}
+
+/**
+ * def settimeout(self, value)
+ */
+static mp_obj_t class_ssl_socket_settimeout(mp_obj_t self_in,
+                                            mp_obj_t value_in)
+{
+    struct class_ssl_socket_t *self_p;
+    mp_obj_t dest[3];
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+    mp_load_method(self_p->sock_obj, MP_QSTR_settimeout, dest);
+    dest[2] = value_in;
+
+    return (mp_call_method_n_kw(1, 0, dest));
+}
+
+/**
+ * Stream read. Blocks for the rest of a partially received record,
+ * like recv().
+ */
+static mp_uint_t class_ssl_socket_stream_read(mp_obj_t self_in,
+                                              void *buf_p,
+                                              mp_uint_t size,
+                                              int *errcode_p)
+{
+    struct class_ssl_socket_t *self_p;
+    ssize_t res;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+    res = ssl_socket_wait_readable(self_p);
+
+    if (res != 0) {
+        *errcode_p = -res;
+
+        return (MP_STREAM_ERROR);
+    }
+
+    MODULE_THREAD_PARK(res = ssl_socket_read(&self_p->socket, buf_p, size));
+
+    if (res < 0) {
+        *errcode_p = MP_EIO;
+
+        return (MP_STREAM_ERROR);
+    }
+
+    return (res);
+}
+
+static mp_uint_t class_ssl_socket_stream_write(mp_obj_t self_in,
+                                               const void *buf_p,
+                                               mp_uint_t size,
+                                               int *errcode_p)
+{
+    struct class_ssl_socket_t *self_p;
+    ssize_t res;
+
+    self_p = MP_OBJ_TO_PTR(self_in);
+
+    MODULE_THREAD_PARK(res = ssl_socket_write(&self_p->socket, buf_p, size));
+
+    if (res < 0) {
+        *errcode_p = MP_EIO;
+
+        return (MP_STREAM_ERROR);
+    }
+
+    return (res);
+}
+
 static MP_DEFINE_CONST_FUN_OBJ_2(class_ssl_socket_recv_obj, class_ssl_socket_recv);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(class_ssl_socket_recv_into_obj,
+                                           2,
+                                           3,
+                                           class_ssl_socket_recv_into);
 static MP_DEFINE_CONST_FUN_OBJ_2(class_ssl_socket_send_obj, class_ssl_socket_send);
+static MP_DEFINE_CONST_FUN_OBJ_2(class_ssl_socket_setblocking_obj,
+                                 class_ssl_socket_setblocking);
+static MP_DEFINE_CONST_FUN_OBJ_2(class_ssl_socket_settimeout_obj,
+                                 class_ssl_socket_settimeout);
 static MP_DEFINE_CONST_FUN_OBJ_1(class_ssl_socket_close_obj, class_ssl_socket_close);
 static MP_DEFINE_CONST_FUN_OBJ_1(class_ssl_socket_cipher_obj, class_ssl_socket_cipher);
 static MP_DEFINE_CONST_FUN_OBJ_1(class_ssl_socket_get_server_hostname_obj,
@@ -413,22 +1318,42 @@ static MP_DEFINE_CONST_FUN_OBJ_1(class_ssl_socket_get_server_hostname_obj,
 
 static const mp_rom_map_elem_t class_ssl_socket_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_recv), MP_ROM_PTR(&class_ssl_socket_recv_obj) },
+    { MP_ROM_QSTR(MP_QSTR_recv_into), MP_ROM_PTR(&class_ssl_socket_recv_into_obj) },
     { MP_ROM_QSTR(MP_QSTR_send), MP_ROM_PTR(&class_ssl_socket_send_obj) },
     { MP_ROM_QSTR(MP_QSTR_close), MP_ROM_PTR(&class_ssl_socket_close_obj) },
     { MP_ROM_QSTR(MP_QSTR_cipher), MP_ROM_PTR(&class_ssl_socket_cipher_obj) },
     { MP_ROM_QSTR(MP_QSTR_get_server_hostname),
-      MP_ROM_PTR(&class_ssl_socket_get_server_hostname_obj) }
+      MP_ROM_PTR(&class_ssl_socket_get_server_hostname_obj) },
+    { MP_ROM_QSTR(MP_QSTR_setblocking),
+      MP_ROM_PTR(&class_ssl_socket_setblocking_obj) },
+    { MP_ROM_QSTR(MP_QSTR_settimeout),
+      MP_ROM_PTR(&class_ssl_socket_settimeout_obj) },
+
+    /* Stream protocol. */
+    { MP_ROM_QSTR(MP_QSTR_read), MP_ROM_PTR(&mp_stream_read_obj) },
+    { MP_ROM_QSTR(MP_QSTR_readinto), MP_ROM_PTR(&mp_stream_readinto_obj) },
+    { MP_ROM_QSTR(MP_QSTR_readline), MP_ROM_PTR(&mp_stream_unbuffered_readline_obj) },
+    { MP_ROM_QSTR(MP_QSTR_write), MP_ROM_PTR(&mp_stream_write_obj) }
 };
 
 static MP_DEFINE_CONST_DICT(class_ssl_socket_locals_dict,
                             class_ssl_socket_locals_dict_table);
 
+/**
+ * The SSL socket stream.
+ */
+static const mp_stream_p_t class_ssl_socket_stream = {
+    .read = class_ssl_socket_stream_read,
+    .write = class_ssl_socket_stream_write,
+};
+
 /**
  * The SSLSocket class.
  */
 const mp_obj_type_t module_ssl_class_ssl_socket = {
     { &mp_type_type },
     .name = MP_QSTR_SSLSocket,
+    .protocol = &class_ssl_socket_stream,
     .locals_dict = (void*)&class_ssl_socket_locals_dict,
 };
 
@@ -438,11 +1363,95 @@ const mp_obj_type_t module_ssl_class_ssl_socket = {
 static mp_obj_t module_init(void)
 {
     ssl_module_init();
+#if CONFIG_PUMBAA_SSL_LOW_RAM == 1
+    sem_init(&cert_cache.sem, 0, 1);
+#endif
 
     return (mp_const_none);
 }
 
+/**
+ * def flush_cert_cache()
+ *
+ * Forget all shared certificate chains and private keys that are not
+ * used by a context, so that their files are parsed again when
+ * loaded by a context. Changed files of a different size are
+ * detected without flushing. Entries used by a context are kept, as
+ * their data can never be freed. Returns the number of kept entries.
+ */
+static mp_obj_t module_flush_cert_cache(void)
+{
+#if CONFIG_PUMBAA_SSL_LOW_RAM == 1
+    struct cert_cache_entry_t *entry_p;
+    int kept;
+    int i;
+
+    kept = 0;
+    sem_take(&cert_cache.sem, NULL);
+
+    for (i = 0; i < membersof(cert_cache.entries); i++) {
+        entry_p = &cert_cache.entries[i];
+
+        if ((entry_p->parsed == 1) && (entry_p->path[0] != '\0')) {
+            if (entry_p->in_use == 1) {
+                kept++;
+            } else {
+                cert_cache_retire(entry_p);
+            }
+        }
+    }
+
+    sem_give(&cert_cache.sem, 1);
+
+    return (MP_OBJ_NEW_SMALL_INT(kept));
+#else
+    mp_not_implemented("flush_cert_cache");
+
+    return (mp_const_none);
+#endif
+}
+
+/**
+ * def connection_footprint_estimate()
+ *
+ * Returns a tuple of the estimated number of heap bytes used by an
+ * established SSL connection and the part of it used by its record
+ * buffers. The estimate is a compile time sum of structure sizes, not
+ * a measurement, and does not include allocations made by mbedtls
+ * for certificates and ciphers. The record buffer size is set by
+ * MBEDTLS_SSL_MAX_CONTENT_LEN, which is lowered to
+ * PUMBAA_SSL_MAX_CONTENT_LEN in make/app.mk for ESP32 builds. Peers
+ * must then honour the requested maximum fragment length, as larger
+ * records do not fit in the buffers. The handshake buffers are freed
+ * when the handshake completes and are not included.
+ */
+static mp_obj_t module_connection_footprint_estimate(void)
+{
+#if CONFIG_PUMBAA_SSL_LOW_RAM == 1
+    mp_obj_t items[2];
+    size_t buffers;
+
+    buffers = (2 * MBEDTLS_SSL_BUFFER_LEN);
+    items[0] = MP_OBJ_NEW_SMALL_INT(sizeof(struct class_ssl_socket_t)
+                                    + sizeof(mbedtls_ssl_context)
+                                    + sizeof(mbedtls_ssl_transform)
+                                    + sizeof(mbedtls_ssl_session)
+                                    + buffers);
+    items[1] = MP_OBJ_NEW_SMALL_INT(buffers);
+
+    return (mp_obj_new_tuple(2, items));
+#else
+    mp_not_implemented("connection_footprint_estimate");
+
+    return (mp_const_none);
+#endif
+}
+
 static MP_DEFINE_CONST_FUN_OBJ_0(module_init_obj, module_init);
+static MP_DEFINE_CONST_FUN_OBJ_0(module_flush_cert_cache_obj,
+                                 module_flush_cert_cache);
+static MP_DEFINE_CONST_FUN_OBJ_0(module_connection_footprint_estimate_obj,
+                                 module_connection_footprint_estimate);
 
 /**
  * The module globals table.
@@ -451,6 +1460,12 @@ static const mp_rom_map_elem_t mp_module_ssl_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_ussl) },
     { MP_ROM_QSTR(MP_QSTR___init__), MP_ROM_PTR(&module_init_obj) },
 
+    /* Functions. */
+    { MP_ROM_QSTR(MP_QSTR_flush_cert_cache),
+      MP_ROM_PTR(&module_flush_cert_cache_obj) },
+    { MP_ROM_QSTR(MP_QSTR_connection_footprint_estimate),
+      MP_ROM_PTR(&module_connection_footprint_estimate_obj) },
+
     /* Types. */
     { MP_ROM_QSTR(MP_QSTR_SSLContext), MP_ROM_PTR(&module_ssl_class_ssl_context) },
     { MP_ROM_QSTR(MP_QSTR_SSLSocket), MP_ROM_PTR(&module_ssl_class_ssl_socket) },
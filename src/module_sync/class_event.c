@@ -76,11 +76,14 @@ static mp_obj_t class_event_read(mp_obj_t self_in, mp_obj_t mask_in)
 {
     struct class_event_t *self_p;
     uint32_t mask;
+    ssize_t res;
 
     self_p = MP_OBJ_TO_PTR(self_in);
     mask = mp_obj_get_int(mask_in);
 
-    if (event_read(&self_p->event, &mask, sizeof(mask)) != sizeof(mask)) {
+    MODULE_THREAD_PARK(res = event_read(&self_p->event, &mask, sizeof(mask)));
+
+    if (res != sizeof(mask)) {
         nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
                                            "failed to read event mask"));
     }
@@ -82,7 +82,7 @@ static mp_obj_t class_queue_read(mp_obj_t self_in, mp_obj_t size_in)
     size = mp_obj_get_int(size_in);
     vstr_init_len(&vstr, size);
 
-    size = queue_read(&self_p->queue, vstr.buf, size);
+    MODULE_THREAD_PARK(size = queue_read(&self_p->queue, vstr.buf, size));
 
     if (size <= 0) {
         nlr_raise(mp_obj_new_exception_msg(&mp_type_OSError,
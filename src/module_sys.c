@@ -89,6 +89,15 @@ static mp_uint_t class_output_write(mp_obj_t self_in,
     return (size);
 }
 
+static mp_obj_t class_output_flush(mp_obj_t self_in)
+{
+    mp_hal_stdout_flush();
+
+    return (mp_const_none);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_1(class_output_flush_obj, class_output_flush);
+
 static mp_obj_t sys_obj___exit__(mp_uint_t n_args, const mp_obj_t *args)
 {
     return (mp_const_none);
@@ -126,6 +135,7 @@ static const mp_obj_type_t class_input = {
 
 static const mp_rom_map_elem_t class_output_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_write), MP_ROM_PTR(&mp_stream_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_flush), MP_ROM_PTR(&class_output_flush_obj) },
     { MP_ROM_QSTR(MP_QSTR_close), MP_ROM_PTR(&mp_identity_obj) },
     { MP_ROM_QSTR(MP_QSTR___del__), MP_ROM_PTR(&mp_identity_obj) },
     { MP_ROM_QSTR(MP_QSTR___enter__), MP_ROM_PTR(&mp_identity_obj) },
@@ -43,6 +43,8 @@ static mp_obj_t module_emacs(mp_uint_t n_args, const mp_obj_t *args_p)
         path_p = mp_obj_str_get_str(args_p[0]);
     }
     
+    /* The editor writes directly to the output channel. */
+    mp_hal_stdout_flush();
     mp_hal_set_interrupt_char(-1);
     res = emacs(path_p, sys_get_stdin(), sys_get_stdout());
     mp_hal_set_interrupt_char(CHAR_CTRL_C);
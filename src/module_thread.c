@@ -32,6 +32,9 @@
 
 #if MICROPY_PY_THREAD == 1
 
+/* Number of entries in the thread table. Must be a power of two. */
+#define THREAD_TABLE_SIZE CONFIG_PUMBAA_THREAD_TABLE_SIZE
+
 /**
  * This structure forms a linked list, one node per active thread.
  */
@@ -40,14 +43,106 @@ struct thread_t {
     void *state_p;
     void *stack_p;
     intptr_t stack_top;
+    intptr_t volatile stack_pointer;
     struct thread_t *next_p;
 };
 
 extern intptr_t stack_top;
 
-/* The mutex controls access to the linked list of threads. */
+/* The mutex serializes insertions into the linked list of
+   threads. Nodes are only inserted at the head and never removed, so
+   the list can be traversed without taking the mutex. */
 static mp_thread_mutex_t thread_mutex;
-static struct thread_t *threads_p = NULL;
+static struct thread_t *volatile threads_p = NULL;
+
+/* The main thread is looked up without using its environment, as the
+   application may use the environment for other variables. */
+static struct thread_t *main_thread_p = NULL;
+
+/* Open addressing hash table of threads by Simba thread. Entries are
+   only added, with the thread mutex taken, and the Simba thread
+   pointer is written last, so lookups take no lock. Threads that do
+   not fit in the table are only found in the linked list. */
+static struct {
+    struct thrd_t *volatile thrd_p;
+    struct thread_t *volatile thread_p;
+} thread_table[THREAD_TABLE_SIZE];
+
+/* Number of stack bytes scanned in other threads during the last
+   garbage collection. */
+static size_t gc_scanned_bytes = 0;
+
+static size_t thread_table_hash(struct thrd_t *thrd_p)
+{
+    return (((uintptr_t)thrd_p >> 4) & (THREAD_TABLE_SIZE - 1));
+}
+
+/**
+ * Add given thread to the thread table. The thread mutex must be
+ * taken by the caller.
+ */
+static void thread_table_add(struct thread_t *thread_p)
+{
+    size_t index;
+    size_t i;
+
+    index = thread_table_hash(thread_p->thrd_p);
+
+    for (i = 0; i < THREAD_TABLE_SIZE; i++) {
+        if (thread_table[index].thrd_p == NULL) {
+            thread_table[index].thread_p = thread_p;
+            thread_table[index].thrd_p = thread_p->thrd_p;
+
+            return;
+        }
+
+        index = ((index + 1) & (THREAD_TABLE_SIZE - 1));
+    }
+}
+
+/**
+ * Find the calling thread. The main thread and threads in the thread
+ * table are found without traversing the linked list of threads.
+ */
+static struct thread_t *thread_self(void)
+{
+    struct thread_t *thread_p;
+    struct thrd_t *thrd_p;
+    size_t index;
+    size_t i;
+
+    thrd_p = thrd_self();
+
+    if (main_thread_p->thrd_p == thrd_p) {
+        return (main_thread_p);
+    }
+
+    index = thread_table_hash(thrd_p);
+
+    for (i = 0; i < THREAD_TABLE_SIZE; i++) {
+        if (thread_table[index].thrd_p == thrd_p) {
+            return (thread_table[index].thread_p);
+        }
+
+        if (thread_table[index].thrd_p == NULL) {
+            break;
+        }
+
+        index = ((index + 1) & (THREAD_TABLE_SIZE - 1));
+    }
+
+    thread_p = threads_p;
+
+    while (thread_p != NULL) {
+        if (thread_p->thrd_p == thrd_p) {
+            break;
+        }
+
+        thread_p = thread_p->next_p;
+    }
+
+    return (thread_p);
+}
 
 void module_thread_init(void)
 {
@@ -59,14 +154,18 @@ void module_thread_init(void)
     threads_p->thrd_p = thrd_self();
     threads_p->state_p = &mp_state_ctx.thread;
     threads_p->stack_top = stack_top;
+    threads_p->stack_pointer = -1;
     threads_p->next_p = NULL;
+    main_thread_p = threads_p;
 }
 
 void mp_thread_gc_others(void)
 {
     struct thread_t *thread_p;
+    struct thrd_t *self_p;
     intptr_t stack_bottom;
     size_t stack_size;
+    int dummy;
 
     mp_thread_mutex_lock(&thread_mutex, 1);
 
@@ -74,18 +173,30 @@ void mp_thread_gc_others(void)
     gc_collect_root((void**)&threads_p, 1);
 
     /* Trace pointers on all threads' stacks. */
+    self_p = thrd_self();
     thread_p = threads_p;
+    gc_scanned_bytes = 0;
 
     while (thread_p != NULL) {
         /* Do not trace stacks that does not have any heap
            pointers. Useful for non-Python threads calling Python
            callbacks. */
         if (thread_p->stack_top != -1) {
-            stack_bottom = (intptr_t)thrd_get_bottom_of_stack(thread_p->thrd_p);
+            /* Only trace the live part of the stack if known. That is,
+               for the current thread and for parked threads. */
+            if (thread_p->thrd_p == self_p) {
+                stack_bottom = (intptr_t)&dummy;
+            } else if (thread_p->stack_pointer != -1) {
+                stack_bottom = thread_p->stack_pointer;
+            } else {
+                stack_bottom = (intptr_t)thrd_get_bottom_of_stack(thread_p->thrd_p);
+            }
+
             stack_bottom &= -4;
             stack_size = (thread_p->stack_top - stack_bottom);
             gc_collect_root((void **)stack_bottom,
                             stack_size / sizeof(mp_int_t));
+            gc_scanned_bytes += stack_size;
         }
 
         thread_p = thread_p->next_p;
@@ -94,43 +205,56 @@ void mp_thread_gc_others(void)
     mp_thread_mutex_unlock(&thread_mutex);
 }
 
-mp_state_thread_t *mp_thread_get_state(void)
+void *module_thread_park(void *regs_p)
 {
     struct thread_t *thread_p;
+    int dummy;
 
-    mp_thread_mutex_lock(&thread_mutex, 1);
-
-    thread_p = threads_p;
+    (void)regs_p;
 
-    while (thread_p != NULL) {
-        if (thread_p->thrd_p == thrd_self()) {
-            break;
-        }
+    /* The address of a local variable in this function is below the
+       caller's stack frame, which holds the saved registers. */
+    thread_p = thread_self();
 
-        thread_p = thread_p->next_p;
+    if (thread_p != NULL) {
+        thread_p->stack_pointer = (intptr_t)&dummy;
     }
 
-    mp_thread_mutex_unlock(&thread_mutex);
-
-    return (thread_p->state_p);
+    return (thread_p);
 }
 
-void mp_thread_set_state(void *state_p)
+void module_thread_unpark(void *park_p)
 {
     struct thread_t *thread_p;
 
-    mp_thread_mutex_lock(&thread_mutex, 1);
+    thread_p = park_p;
 
-    thread_p = threads_p;
+    if (thread_p != NULL) {
+        thread_p->stack_pointer = -1;
+    }
+}
 
-    while (thread_p != NULL) {
-        if (thread_p->thrd_p == thrd_self()) {
-            break;
-        }
+void module_thread_mem_info(void)
+{
+    mp_printf(&mp_plat_print,
+              "thread stacks: %u bytes scanned in last collection\n",
+              (unsigned)gc_scanned_bytes);
+}
 
-        thread_p = thread_p->next_p;
-    }
+mp_state_thread_t *mp_thread_get_state(void)
+{
+    return (thread_self()->state_p);
+}
 
+void mp_thread_set_state(void *state_p)
+{
+    struct thread_t *thread_p;
+
+    /* A spawned thread may run before its creator has added it to
+       the list of threads, so wait for the creator to release the
+       mutex. */
+    mp_thread_mutex_lock(&thread_mutex, 1);
+    thread_p = thread_self();
     mp_thread_mutex_unlock(&thread_mutex);
 
     thread_p->state_p = state_p;
@@ -169,10 +293,12 @@ void mp_thread_create(void *(*entry)(void*),
                                   thread_p->stack_p,
                                   *stack_size_p);
     thread_p->stack_top = (intptr_t)thrd_get_top_of_stack(thread_p->thrd_p);
+    thread_p->stack_pointer = -1;
 
     /* Add thread to linked list of all threads. */
     thread_p->next_p = threads_p;
     threads_p = thread_p;
+    thread_table_add(thread_p);
 
     mp_thread_mutex_unlock(&thread_mutex);
 
@@ -199,12 +325,14 @@ void mp_thread_add_end(void *v_thread_p, struct thrd_t *thrd_p)
     thread_p = v_thread_p;
     thread_p->stack_p = NULL;
     thread_p->stack_top = (intptr_t)thrd_get_top_of_stack(thrd_p);
+    thread_p->stack_pointer = -1;
     thread_p->thrd_p = thrd_p;
     thread_p->state_p = &mp_state_ctx.thread;
 
     /* Add thread to linked list of all threads. */
     thread_p->next_p = threads_p;
     threads_p = thread_p;
+    thread_table_add(thread_p);
 
     mp_thread_mutex_unlock(&thread_mutex);
 }
@@ -212,7 +340,8 @@ void mp_thread_add_end(void *v_thread_p, struct thrd_t *thrd_p)
 void mp_thread_finish(void)
 {
     /* Remove once the thread is correctly removed from the simba
-       thread list. */
+       thread list. The thread has no live heap pointers left. */
+    module_thread_park(NULL);
     thrd_suspend(NULL);
 }
 
@@ -223,7 +352,19 @@ void mp_thread_mutex_init(mp_thread_mutex_t *mutex_p)
 
 int mp_thread_mutex_lock(mp_thread_mutex_t *mutex_p, int wait)
 {
-    return (sem_take(&mutex_p->sem, NULL));
+    struct time_t timeout;
+    struct time_t *timeout_p;
+
+    timeout_p = NULL;
+
+    if (wait == 0) {
+        timeout.seconds = 0;
+        timeout.nanoseconds = 0;
+        timeout_p = &timeout;
+    }
+
+    /* Returns 1 if the mutex was taken, otherwise 0. */
+    return (sem_take(&mutex_p->sem, timeout_p) == 0);
 }
 
 void mp_thread_mutex_unlock(mp_thread_mutex_t *mutex_p)
@@ -93,16 +93,25 @@ static mp_obj_t module_time_time(void)
 static mp_obj_t module_time_sleep(mp_obj_t arg_p)
 {
 #if MICROPY_PY_BUILTINS_FLOAT
-    thrd_sleep(mp_obj_get_float(arg_p));
+    float seconds;
+
+    seconds = mp_obj_get_float(arg_p);
+    MODULE_THREAD_PARK(thrd_sleep(seconds));
 #else
-    thrd_sleep(mp_obj_get_int(arg_p));
+    int seconds;
+
+    seconds = mp_obj_get_int(arg_p);
+    MODULE_THREAD_PARK(thrd_sleep(seconds));
 #endif
     return (mp_const_none);
 }
 
 static mp_obj_t module_time_sleep_ms(mp_obj_t arg)
 {
-    thrd_sleep_ms(mp_obj_get_int(arg));
+    int ms;
+
+    ms = mp_obj_get_int(arg);
+    MODULE_THREAD_PARK(thrd_sleep_ms(ms));
 
     return (mp_const_none);
 }
@@ -0,0 +1,300 @@
+/**
+ * @section License
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016-2017, Erik Moqvist
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * This file is part of the Pumbaa project.
+ */
+
+
+#include "pumbaa.h"
+
+#if CONFIG_PUMBAA_BYTECODE_CACHE == 1
+
+#include "py/persistentcode.h"
+#include "extmod/uzlib/tinf.h"
+
+/* Size of the header in front of the bytecode in a cache file. */
+#define HEADER_SIZE                                         8
+
+/**
+ * The source file size and CRC-32 are stored in the cache file
+ * header. Simba file systems do not keep modification times, so the
+ * checksum is used to detect a modified source file of unchanged
+ * size.
+ */
+struct source_info_t {
+    uint32_t size;
+    uint32_t crc;
+};
+
+static struct {
+    unsigned long hits;
+    unsigned long misses;
+} module = { 0, 0 };
+
+/**
+ * Create the cache file path of given source file path. The bytecode
+ * of dir/name.py is cached in dir/<cache directory>/name.mpy. The
+ * length of the cache directory path is written to dir_length_p.
+ */
+static void cache_path(vstr_t *path_p,
+                       const char *source_path_p,
+                       size_t *dir_length_p)
+{
+    const char *name_p;
+    size_t name_length;
+
+    name_p = strrchr(source_path_p, '/');
+
+    if (name_p == NULL) {
+        name_p = source_path_p;
+    } else {
+        name_p++;
+        vstr_add_strn(path_p, source_path_p, name_p - source_path_p);
+    }
+
+    name_length = strlen(name_p);
+
+    if ((name_length > 3) && (strcmp(&name_p[name_length - 3], ".py") == 0)) {
+        name_length -= 3;
+    }
+
+    vstr_add_str(path_p, CONFIG_PUMBAA_BYTECODE_CACHE_DIR);
+    *dir_length_p = path_p->len;
+    vstr_add_char(path_p, '/');
+    vstr_add_strn(path_p, name_p, name_length);
+    vstr_add_str(path_p, ".mpy");
+}
+
+/**
+ * Read given source file and calculate its size and CRC-32. Returns
+ * zero(0) or negative error code.
+ */
+static int source_info(const char *path_p, struct source_info_t *info_p)
+{
+    struct fs_file_t file;
+    byte *buf_p;
+    ssize_t size;
+    uint32_t crc;
+
+    buf_p = m_new_maybe(byte, CONFIG_PUMBAA_LEXER_FILE_BUFFER_SIZE);
+
+    if (buf_p == NULL) {
+        return (-ENOMEM);
+    }
+
+    if (fs_open(&file, path_p, FS_READ) != 0) {
+        m_del(byte, buf_p, CONFIG_PUMBAA_LEXER_FILE_BUFFER_SIZE);
+
+        return (-ENOENT);
+    }
+
+    info_p->size = 0;
+    crc = 0xffffffff;
+
+    while ((size = fs_read(&file,
+                           buf_p,
+                           CONFIG_PUMBAA_LEXER_FILE_BUFFER_SIZE)) > 0) {
+        crc = uzlib_crc32(buf_p, size, crc);
+        info_p->size += size;
+    }
+
+    info_p->crc = (crc ^ 0xffffffff);
+    fs_close(&file);
+    m_del(byte, buf_p, CONFIG_PUMBAA_LEXER_FILE_BUFFER_SIZE);
+
+    return (size < 0 ? -EIO : 0);
+}
+
+static void header_pack(byte *header_p, struct source_info_t *info_p)
+{
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        header_p[i] = (info_p->size >> (8 * i));
+        header_p[i + 4] = (info_p->crc >> (8 * i));
+    }
+}
+
+/**
+ * Load the bytecode in given cache file if it was compiled from a
+ * source file with given size and CRC-32. Returns the raw code or
+ * NULL if the cache file is missing, stale or corrupt.
+ */
+static mp_raw_code_t *cache_load(const char *path_p,
+                                 struct source_info_t *info_p)
+{
+    mp_reader_t reader;
+    byte expected[HEADER_SIZE];
+    mp_uint_t value;
+    mp_raw_code_t *raw_code_p;
+    nlr_buf_t nlr;
+    int i;
+
+    if (mp_reader_new_file(&reader, path_p) != 0) {
+        return (NULL);
+    }
+
+    header_pack(&expected[0], info_p);
+
+    for (i = 0; i < HEADER_SIZE; i++) {
+        value = reader.readbyte(reader.data);
+
+        if (value != expected[i]) {
+            reader.close(reader.data);
+
+            return (NULL);
+        }
+    }
+
+    /* The reader is closed by mp_raw_code_load() on success. */
+    if (nlr_push(&nlr) == 0) {
+        raw_code_p = mp_raw_code_load(&reader);
+        nlr_pop();
+    } else {
+        reader.close(reader.data);
+        raw_code_p = NULL;
+    }
+
+    return (raw_code_p);
+}
+
+/**
+ * Write given raw code to given cache file. Failures are ignored, the
+ * module is compiled again on next import.
+ */
+static void cache_store(vstr_t *path_p,
+                        size_t dir_length,
+                        struct source_info_t *info_p,
+                        mp_raw_code_t *raw_code_p)
+{
+    vstr_t data;
+    mp_print_t print;
+    struct fs_stat_t stat;
+    struct fs_file_t file;
+    nlr_buf_t nlr;
+    ssize_t size;
+
+    /* Serialize the bytecode before touching the file system, as
+       saving raises an exception for native code. */
+    vstr_init_print(&data, 256, &print);
+    vstr_add_len(&data, HEADER_SIZE);
+    header_pack((byte *)data.buf, info_p);
+
+    if (nlr_push(&nlr) == 0) {
+        mp_raw_code_save(raw_code_p, &print);
+        nlr_pop();
+    } else {
+        vstr_clear(&data);
+
+        return;
+    }
+
+    /* Create the cache directory if missing. */
+    path_p->buf[dir_length] = '\0';
+
+    if (fs_stat(path_p->buf, &stat) != 0) {
+        PORT_IMPORT_STAT_CACHE_INVALIDATE();
+        fs_mkdir(path_p->buf);
+    }
+
+    path_p->buf[dir_length] = '/';
+
+    if (fs_open(&file, path_p->buf, FS_WRITE | FS_CREAT | FS_TRUNC) == 0) {
+        size = fs_write(&file, data.buf, data.len);
+        fs_close(&file);
+
+        if (size != (ssize_t)data.len) {
+            fs_remove(path_p->buf);
+        }
+    }
+
+    vstr_clear(&data);
+}
+
+/**
+ * Parse and compile given source file.
+ */
+static mp_raw_code_t *compile(const char *path_p)
+{
+    mp_lexer_t *lex_p;
+    mp_parse_tree_t parse_tree;
+    qstr source_name;
+
+    lex_p = mp_lexer_new_from_file(path_p);
+
+    if (lex_p == NULL) {
+        return (NULL);
+    }
+
+    source_name = lex_p->source_name;
+    parse_tree = mp_parse(lex_p, MP_PARSE_FILE_INPUT);
+
+    return (mp_compile_to_raw_code(&parse_tree,
+                                   source_name,
+                                   MP_EMIT_OPT_NONE,
+                                   false));
+}
+
+mp_raw_code_t *bytecode_cache_port_load(const char *path_p)
+{
+    struct source_info_t info;
+    vstr_t path;
+    size_t dir_length;
+    mp_raw_code_t *raw_code_p;
+
+    if (source_info(path_p, &info) != 0) {
+        return (NULL);
+    }
+
+    vstr_init(&path, strlen(path_p) + 16);
+    cache_path(&path, path_p, &dir_length);
+    raw_code_p = cache_load(vstr_null_terminated_str(&path), &info);
+
+    if (raw_code_p != NULL) {
+        module.hits++;
+    } else {
+        module.misses++;
+        raw_code_p = compile(path_p);
+
+        if (raw_code_p != NULL) {
+            cache_store(&path, dir_length, &info, raw_code_p);
+        }
+    }
+
+    vstr_clear(&path);
+
+    return (raw_code_p);
+}
+
+void bytecode_cache_port_get_info(unsigned long *hits_p,
+                                  unsigned long *misses_p)
+{
+    *hits_p = module.hits;
+    *misses_p = module.misses;
+}
+
+#endif
@@ -58,9 +58,9 @@
 
 struct lexer_file_t {
     struct fs_file_t file;
-    byte buf[20];
     mp_uint_t len;
     mp_uint_t pos;
+    byte buf[CONFIG_PUMBAA_LEXER_FILE_BUFFER_SIZE];
 };
 
 static mp_uint_t lexer_file_readbyte(void *lexer_file_p)
@@ -98,29 +98,49 @@ static void lexer_file_close(void *lexer_file_p)
     m_del_obj(struct lexer_file_t, lf_p);
 }
 
-mp_lexer_t *mp_lexer_new_from_file(const char *filename_p)
+/**
+ * Create a reader of given file. Used by the lexer when compiling
+ * source files and when loading precompiled .mpy files. Returns
+ * zero(0) on success, otherwise a positive error code.
+ */
+int mp_reader_new_file(mp_reader_t *reader_p, const char *filename_p)
 {
-    mp_reader_t reader;
     struct lexer_file_t *lf_p;
     int n;
 
     lf_p = m_new_obj_maybe(struct lexer_file_t);
 
     if (lf_p == NULL) {
-        return (NULL);
+        return (MP_ENOMEM);
     }
 
     if (fs_open(&lf_p->file, filename_p, FS_READ) != 0) {
         m_del_obj(struct lexer_file_t, lf_p);
-        return (NULL);
+        return (MP_ENOENT);
     }
 
     n = fs_read(&lf_p->file, lf_p->buf, sizeof(lf_p->buf));
+
+    if (n < 0) {
+        n = 0;
+    }
+
     lf_p->len = n;
     lf_p->pos = 0;
-    reader.data = lf_p;
-    reader.readbyte = lexer_file_readbyte;
-    reader.close = lexer_file_close;
+    reader_p->data = lf_p;
+    reader_p->readbyte = lexer_file_readbyte;
+    reader_p->close = lexer_file_close;
+
+    return (0);
+}
+
+mp_lexer_t *mp_lexer_new_from_file(const char *filename_p)
+{
+    mp_reader_t reader;
+
+    if (mp_reader_new_file(&reader, filename_p) != 0) {
+        return (NULL);
+    }
 
     return (mp_lexer_new(qstr_from_str(filename_p), reader));
 }
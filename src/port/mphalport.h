@@ -35,4 +35,16 @@ static inline mp_uint_t mp_hal_ticks_ms(void) { return 0; }
 
 void mp_hal_set_interrupt_char(char c);
 
+/**
+ * Initialize the port layer.
+ */
+void mp_hal_init(void);
+
+/**
+ * Write any buffered standard output data to the output channel. C
+ * code writing directly to the output channel, for example with
+ * std_printf(), must call this first to keep the output in order.
+ */
+void mp_hal_stdout_flush(void);
+
 #endif
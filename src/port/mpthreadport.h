@@ -31,6 +31,7 @@
 #ifndef __MPTHREADPORT_H__
 #define __MPTHREADPORT_H__
 
+#include <setjmp.h>
 #include "simba.h"
 
 typedef struct _mp_thread_mutex_t {
@@ -44,4 +45,49 @@ void module_thread_init(void);
 
 void mp_thread_gc_others(void);
 
+/**
+ * Mark the calling thread as parked before a blocking call, and as
+ * running again after it. Only the part of a parked thread's stack
+ * that is in use is scanned by the garbage collector. The value
+ * returned by module_thread_park() is passed to
+ * module_thread_unpark(), saving a second thread lookup. Use
+ * MODULE_THREAD_PARK() instead of calling these functions directly.
+ */
+void *module_thread_park(void *regs_p);
+
+void module_thread_unpark(void *park_p);
+
+/**
+ * Print thread statistics in micropython.mem_info().
+ */
+void module_thread_mem_info(void);
+
+/**
+ * Execute given blocking statement with the calling thread
+ * parked. The registers are saved on the stack first, as they may
+ * hold heap pointers. The thread is unparked before an exception
+ * raised by the statement is passed on, as a stale stack pointer
+ * would hide the frames of the exception handlers from the garbage
+ * collector. The statement must not leave the macro with return,
+ * break or continue.
+ */
+#define MODULE_THREAD_PARK(statement)           \
+    do {                                        \
+        jmp_buf regs;                           \
+        nlr_buf_t nlr;                          \
+        void *park_p;                           \
+                                                \
+        setjmp(regs);                           \
+        park_p = module_thread_park(&regs);     \
+                                                \
+        if (nlr_push(&nlr) == 0) {              \
+            statement;                          \
+            nlr_pop();                          \
+            module_thread_unpark(park_p);       \
+        } else {                                \
+            module_thread_unpark(park_p);       \
+            nlr_jump(nlr.ret_val);              \
+        }                                       \
+    } while (0)
+
 #endif
@@ -35,6 +35,35 @@ intptr_t *stack_top;
 /* The character that raises a keyboard exception. */
 static char interrupt_char = -1;
 
+#if CONFIG_PUMBAA_STDOUT_BUFFER_SIZE > 0
+
+/* Standard output is buffered and written to the output channel a
+   line at a time. */
+static struct {
+    struct sem_t sem;
+    size_t size;
+    char buf[CONFIG_PUMBAA_STDOUT_BUFFER_SIZE];
+} stdout_buffer;
+
+static void stdout_buffer_flush(void)
+{
+    if (stdout_buffer.size > 0) {
+        chan_write(sys_get_stdout(), &stdout_buffer.buf[0], stdout_buffer.size);
+        stdout_buffer.size = 0;
+    }
+}
+
+static void stdout_buffer_put(char c)
+{
+    if (stdout_buffer.size == sizeof(stdout_buffer.buf)) {
+        stdout_buffer_flush();
+    }
+
+    stdout_buffer.buf[stdout_buffer.size++] = c;
+}
+
+#endif
+
 /**
  * The write filter callback that raises the keyboard exception when
  * the interrupt character is read.
@@ -54,15 +83,9 @@ static int write_filter_isr(void *self_p, const void *buf_p, size_t size)
     return (0);
 }
 
-mp_import_stat_t mp_import_stat(const char *path_p)
+static mp_import_stat_t import_stat_from_type(int type)
 {
-    struct fs_stat_t stat;
-
-    if (fs_stat(path_p, &stat) != 0) {
-        return (MP_IMPORT_STAT_NO_EXIST);
-    }
-
-    switch (stat.type) {
+    switch (type) {
 
     case FS_TYPE_FILE:
     case FS_TYPE_SOFT_LINK:
@@ -77,12 +100,242 @@ mp_import_stat_t mp_import_stat(const char *path_p)
     }
 }
 
+#if CONFIG_PUMBAA_IMPORT_STAT_CACHE == 1
+
+/* Directory listings read by the import machinery. The cache is a
+   dict of directory paths to dicts of lower case entry names to
+   (name, import stat) tuples, stored in a root pointer. Only
+   directories that could be opened are cached. The cache is only
+   invalidated by writes made through the Python modules, so files
+   created by C code are not seen until the cache is invalidated. */
+static struct {
+    unsigned long hits;
+    unsigned long misses;
+} import_stat_cache;
+
+static mp_obj_t new_str_lower(const char *str_p, size_t length)
+{
+    vstr_t vstr;
+    size_t i;
+
+    vstr_init_len(&vstr, length);
+
+    for (i = 0; i < length; i++) {
+        vstr.buf[i] = unichar_tolower(str_p[i]);
+    }
+
+    return (mp_obj_new_str_from_vstr(&mp_type_str, &vstr));
+}
+
+/**
+ * Read all entries in given directory. Returns MP_OBJ_NULL if the
+ * directory could not be opened.
+ */
+static mp_obj_t import_stat_cache_read_dir(const char *path_p)
+{
+    struct fs_dir_t dir;
+    struct fs_dir_entry_t entry;
+    mp_obj_t entries;
+    mp_obj_t items[2];
+    size_t length;
+
+    if (fs_dir_open(&dir, path_p, FS_READ) != 0) {
+        return (MP_OBJ_NULL);
+    }
+
+    entries = mp_obj_new_dict(0);
+
+    while (fs_dir_read(&dir, &entry) == 1) {
+        length = strlen(&entry.name[0]);
+        items[0] = mp_obj_new_str(&entry.name[0], length, false);
+        items[1] = MP_OBJ_NEW_SMALL_INT(import_stat_from_type(entry.type));
+        mp_obj_dict_store(entries,
+                          new_str_lower(&entry.name[0], length),
+                          mp_obj_new_tuple(2, items));
+    }
+
+    fs_dir_close(&dir);
+
+    return (entries);
+}
+
+/**
+ * Look up given path in the cached listing of its directory. Returns
+ * zero(0) and the import stat if the listing is conclusive, or
+ * negative error code if the file system has to be asked. File system
+ * names may be case insensitive, so a name that only differs in case
+ * from a directory entry is not conclusive.
+ */
+static int import_stat_cache_lookup(const char *path_p,
+                                    mp_import_stat_t *stat_p)
+{
+    const char *name_p;
+    mp_obj_t dir;
+    mp_obj_t entries;
+    mp_map_elem_t *elem_p;
+    mp_obj_t *items_p;
+    size_t name_length;
+
+    name_p = strrchr(path_p, '/');
+
+    if (name_p == NULL) {
+        dir = MP_OBJ_NEW_QSTR(MP_QSTR_);
+        name_p = path_p;
+    } else if (name_p == path_p) {
+        dir = MP_OBJ_NEW_QSTR(MP_QSTR__slash_);
+        name_p++;
+    } else {
+        dir = mp_obj_new_str(path_p, name_p - path_p, false);
+        name_p++;
+    }
+
+    name_length = strlen(name_p);
+
+    if ((name_length == 0)
+        || (strcmp(name_p, ".") == 0)
+        || (strcmp(name_p, "..") == 0)) {
+        return (-EINVAL);
+    }
+
+    if (MP_STATE_VM(import_stat_cache) == MP_OBJ_NULL) {
+        MP_STATE_VM(import_stat_cache) = mp_obj_new_dict(0);
+    }
+
+    elem_p = mp_map_lookup(mp_obj_dict_get_map(MP_STATE_VM(import_stat_cache)),
+                           dir,
+                           MP_MAP_LOOKUP);
+
+    if (elem_p != NULL) {
+        import_stat_cache.hits++;
+        entries = elem_p->value;
+    } else {
+        entries = import_stat_cache_read_dir(mp_obj_str_get_str(dir));
+
+        /* Let the file system answer if the directory could not be
+           read, as it may be created later. */
+        if (entries == MP_OBJ_NULL) {
+            return (-ENOENT);
+        }
+
+        import_stat_cache.misses++;
+
+        /* Start over instead of evicting single directories. */
+        if (mp_obj_dict_len(MP_STATE_VM(import_stat_cache))
+            >= CONFIG_PUMBAA_IMPORT_STAT_CACHE_DIRS) {
+            MP_STATE_VM(import_stat_cache) = mp_obj_new_dict(0);
+        }
+
+        mp_obj_dict_store(MP_STATE_VM(import_stat_cache), dir, entries);
+    }
+
+    elem_p = mp_map_lookup(mp_obj_dict_get_map(entries),
+                           new_str_lower(name_p, name_length),
+                           MP_MAP_LOOKUP);
+
+    if (elem_p == NULL) {
+        *stat_p = MP_IMPORT_STAT_NO_EXIST;
+
+        return (0);
+    }
+
+    mp_obj_get_array_fixed_n(elem_p->value, 2, &items_p);
+
+    if (strcmp(mp_obj_str_get_str(items_p[0]), name_p) != 0) {
+        return (-ENOENT);
+    }
+
+    *stat_p = MP_OBJ_SMALL_INT_VALUE(items_p[1]);
+
+    return (0);
+}
+
+void port_import_stat_cache_invalidate(void)
+{
+    MP_STATE_VM(import_stat_cache) = MP_OBJ_NULL;
+}
+
+void port_import_stat_cache_get_info(unsigned long *hits_p,
+                                     unsigned long *misses_p)
+{
+    *hits_p = import_stat_cache.hits;
+    *misses_p = import_stat_cache.misses;
+}
+
+#endif
+
+mp_import_stat_t mp_import_stat(const char *path_p)
+{
+    struct fs_stat_t stat;
+#if CONFIG_PUMBAA_IMPORT_STAT_CACHE == 1
+    mp_import_stat_t import_stat;
+
+    if (import_stat_cache_lookup(path_p, &import_stat) == 0) {
+        return (import_stat);
+    }
+#endif
+
+    if (fs_stat(path_p, &stat) != 0) {
+        return (MP_IMPORT_STAT_NO_EXIST);
+    }
+
+    return (import_stat_from_type(stat.type));
+}
+
 void nlr_jump_fail(void *val_p)
 {
+    /* The buffered output preceding the failure is often the best
+       hint of what went wrong. */
+    mp_hal_stdout_flush();
     std_printf(FSTR("FATAL: uncaught NLR 0x%x\r\n"), (long)val_p);
     sys_stop(1);
 }
 
+void mp_hal_init(void)
+{
+#if CONFIG_PUMBAA_STDOUT_BUFFER_SIZE > 0
+    sem_init(&stdout_buffer.sem, 0, 1);
+    stdout_buffer.size = 0;
+#endif
+}
+
+void mp_hal_stdout_flush(void)
+{
+#if CONFIG_PUMBAA_STDOUT_BUFFER_SIZE > 0
+    sem_take(&stdout_buffer.sem, NULL);
+    stdout_buffer_flush();
+    sem_give(&stdout_buffer.sem, 1);
+#endif
+}
+
+#if CONFIG_PUMBAA_STDOUT_BUFFER_SIZE > 0
+
+void mp_hal_stdout_tx_strn_cooked(const char *str_p, size_t len)
+{
+    int newline;
+
+    newline = 0;
+
+    sem_take(&stdout_buffer.sem, NULL);
+
+    while (len--) {
+        if (*str_p == '\n') {
+            stdout_buffer_put('\r');
+            newline = 1;
+        }
+
+        stdout_buffer_put(*str_p++);
+    }
+
+    /* Flush complete lines. */
+    if (newline == 1) {
+        stdout_buffer_flush();
+    }
+
+    sem_give(&stdout_buffer.sem, 1);
+}
+
+#else
+
 void mp_hal_stdout_tx_strn_cooked(const char *str_p, size_t len)
 {
     char c;
@@ -98,6 +351,8 @@ void mp_hal_stdout_tx_strn_cooked(const char *str_p, size_t len)
     }
 }
 
+#endif
+
 void mp_hal_stdout_tx_strn(const char *str_p, mp_uint_t len)
 {
     mp_hal_stdout_tx_strn_cooked(str_p, len);
@@ -113,6 +368,8 @@ int mp_hal_stdin_rx_chr(void)
 {
     unsigned char c = 0;
 
+    /* Show any prompt before waiting for input. */
+    mp_hal_stdout_flush();
     chan_read(sys_get_stdin(), &c, 1);
 
     return (c);
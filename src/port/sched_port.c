@@ -0,0 +1,105 @@
+/**
+ * @section License
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016-2017, Erik Moqvist
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * This file is part of the Pumbaa project.
+ */
+
+#include "pumbaa.h"
+
+/* Scheduled callbacks are stored in a ring buffer. Interrupt handlers
+   are the only writers of the head index and the VM is the only
+   writer of the tail index, so no lock is needed to access the ring
+   buffer. */
+static volatile unsigned int head = 0;
+static volatile unsigned int tail = 0;
+static int running = 0;
+
+volatile int sched_port_pending = 0;
+
+int sched_port_schedule_isr(mp_obj_t function, mp_obj_t arg)
+{
+    unsigned int index;
+
+    /* Drop the callback if the ring buffer is full. */
+    if ((head - tail) == CONFIG_PUMBAA_SCHED_QUEUE_LENGTH) {
+        return (-ENOMEM);
+    }
+
+    index = (head % CONFIG_PUMBAA_SCHED_QUEUE_LENGTH);
+    MP_STATE_VM(sched_port_queue)[index].function = function;
+    MP_STATE_VM(sched_port_queue)[index].arg = arg;
+    head++;
+    sched_port_pending = 1;
+
+    return (0);
+}
+
+void sched_port_run(void)
+{
+    nlr_buf_t nlr;
+    mp_obj_t function;
+    mp_obj_t arg;
+    unsigned int index;
+
+    /* Callbacks are not nested, and only one thread runs them. */
+    sys_lock();
+
+    if (running == 1) {
+        sys_unlock();
+
+        return;
+    }
+
+    running = 1;
+    sched_port_pending = 0;
+    sys_unlock();
+
+    while (tail != head) {
+        index = (tail % CONFIG_PUMBAA_SCHED_QUEUE_LENGTH);
+        function = MP_STATE_VM(sched_port_queue)[index].function;
+        arg = MP_STATE_VM(sched_port_queue)[index].arg;
+        MP_STATE_VM(sched_port_queue)[index].function = MP_OBJ_NULL;
+        MP_STATE_VM(sched_port_queue)[index].arg = MP_OBJ_NULL;
+        tail++;
+
+        /* An exception in a callback must not propagate to the
+           interrupted code. */
+        if (nlr_push(&nlr) == 0) {
+            if (arg == MP_OBJ_NULL) {
+                mp_call_function_0(function);
+            } else {
+                mp_call_function_1(function, arg);
+            }
+
+            nlr_pop();
+        } else {
+            mp_obj_print_exception(&mp_plat_print, MP_OBJ_FROM_PTR(nlr.ret_val));
+        }
+    }
+
+    running = 0;
+}
@@ -100,13 +100,37 @@
 extern void *mp_thread_add_begin(void);
 extern void mp_thread_add_end(void *thread_p, struct thrd_t *thrd_p);
 
+/**
+ * Get the file system file of given io file object, or NULL if the
+ * object is not a file.
+ */
+struct fs_file_t *module_io_file_get(mp_obj_t file_in);
+
 #if CONFIG_PUMBAA_MODULE_SOCKET == 1
 
+struct class_socket_address_t {
+    struct inet_addr_t address;
+    mp_obj_t tuple;
+};
+
 struct class_socket_t {
     mp_obj_base_t base;
     struct socket_t socket;
+    struct time_t timeout;
+    struct time_t *timeout_p;
+    struct {
+        struct class_socket_address_t entries[CONFIG_PUMBAA_SOCKET_ADDRESS_CACHE_MAX];
+        int next;
+    } addresses;
 };
 
+/**
+ * Wait for data to become available on given socket within its
+ * timeout. Returns zero(0) if data is available, otherwise negative
+ * error code.
+ */
+int module_socket_wait_readable(struct class_socket_t *self_p);
+
 #endif
 
 #if CONFIG_PUMBAA_MODULE_SSL == 1
@@ -114,6 +138,7 @@ struct class_socket_t {
 struct class_ssl_context_t {
     mp_obj_base_t base;
     struct ssl_context_t context;
+    struct class_ssl_session_cache_t *session_cache_p;
 };
 
 struct class_ssl_socket_t {
@@ -66,7 +66,9 @@ PUMBAA_SRC += \
 	module_text.c \
 	module_time.c \
 	module_thread.c \
-	port/lexer_port.c
+	port/bytecode_cache_port.c \
+	port/lexer_port.c \
+	port/sched_port.c
 
 ifeq ($(BOARD),arduino_due)
 PUMBAA_SRC += \
@@ -216,6 +218,7 @@ MICROPYTHON_SRC += \
 	py/parse.c \
 	py/parsenumbase.c \
 	py/parsenum.c \
+	py/persistentcode.c \
 	py/qstr.c \
 	py/reader.c \
 	py/repl.c \
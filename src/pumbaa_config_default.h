@@ -131,6 +131,10 @@
 #    define MICROPY_PY_CMATH                              (1)
 #endif
 
+#ifndef MICROPY_PY_UERRNO
+#    define MICROPY_PY_UERRNO                             (1)
+#endif
+
 #ifndef MICROPY_PY_UHASHLIB
 #    define MICROPY_PY_UHASHLIB                           (1)
 #endif
@@ -175,6 +179,10 @@
 #    define MICROPY_MODULE_FROZEN_MPY                     (1)
 #endif
 
+#ifndef MICROPY_PERSISTENT_CODE_LOAD
+#    define MICROPY_PERSISTENT_CODE_LOAD                  (1)
+#endif
+
 #ifndef MICROPY_QSTR_EXTRA_POOL
 #    if MICROPY_MODULE_FROZEN_MPY == 1
 #        define MICROPY_QSTR_EXTRA_POOL mp_qstr_frozen_const_pool
@@ -357,6 +365,34 @@
 #    define CONFIG_PUMBAA_CLASS_TIMER                       1
 #endif
 
+#ifndef CONFIG_PUMBAA_LEXER_FILE_BUFFER_SIZE
+#    define CONFIG_PUMBAA_LEXER_FILE_BUFFER_SIZE            512
+#endif
+
+#ifndef CONFIG_PUMBAA_STDOUT_BUFFER_SIZE
+#    define CONFIG_PUMBAA_STDOUT_BUFFER_SIZE                128
+#endif
+
+#ifndef CONFIG_PUMBAA_SCHED_QUEUE_LENGTH
+#    define CONFIG_PUMBAA_SCHED_QUEUE_LENGTH                8
+#endif
+
+#ifndef CONFIG_PUMBAA_BYTECODE_CACHE
+#    define CONFIG_PUMBAA_BYTECODE_CACHE                    0
+#endif
+
+#ifndef CONFIG_PUMBAA_BYTECODE_CACHE_DIR
+#    define CONFIG_PUMBAA_BYTECODE_CACHE_DIR                "mpycache"
+#endif
+
+#ifndef CONFIG_PUMBAA_IMPORT_STAT_CACHE
+#    define CONFIG_PUMBAA_IMPORT_STAT_CACHE                 0
+#endif
+
+#ifndef CONFIG_PUMBAA_IMPORT_STAT_CACHE_DIRS
+#    define CONFIG_PUMBAA_IMPORT_STAT_CACHE_DIRS            8
+#endif
+
 #ifndef CONFIG_PUMBAA_OS_SYSTEM
 #    define CONFIG_PUMBAA_OS_SYSTEM                         1
 #endif
@@ -373,6 +409,10 @@
 #    define CONFIG_PUMBAA_SYS_REBOOT                        1
 #endif
 
+#ifndef CONFIG_PUMBAA_THREAD_TABLE_SIZE
+#    define CONFIG_PUMBAA_THREAD_TABLE_SIZE                 16
+#endif
+
 #ifndef CONFIG_PUMBAA_THRD
 #    if MICROPY_PY_THREAD == 1
 #        define CONFIG_PUMBAA_THRD                          1
@@ -407,6 +447,22 @@
 #    endif
 #endif
 
+#ifndef CONFIG_PUMBAA_CLASS_HTTP_SERVER_IDLE_TIMEOUT
+#    define CONFIG_PUMBAA_CLASS_HTTP_SERVER_IDLE_TIMEOUT 5
+#endif
+
+#ifndef CONFIG_PUMBAA_CLASS_HTTP_SERVER_STATIC_ETAG_CACHE_MAX
+#    define CONFIG_PUMBAA_CLASS_HTTP_SERVER_STATIC_ETAG_CACHE_MAX 4
+#endif
+
+#ifndef CONFIG_PUMBAA_CLASS_HTTP_SERVER_STATIC_GZIP
+#    define CONFIG_PUMBAA_CLASS_HTTP_SERVER_STATIC_GZIP 0
+#endif
+
+#ifndef CONFIG_PUMBAA_CLASS_HTTP_SERVER_STREAM_BUFFER_SIZE
+#    define CONFIG_PUMBAA_CLASS_HTTP_SERVER_STREAM_BUFFER_SIZE 512
+#endif
+
 #ifndef CONFIG_PUMBAA_MODULE_SOCKET
 #    if defined(CONFIG_MINIMAL_SYSTEM) || defined(ARCH_ARM)
 #        define CONFIG_PUMBAA_MODULE_SOCKET                 0
@@ -423,6 +479,14 @@
 #    endif
 #endif
 
+#ifndef CONFIG_PUMBAA_MODULE_UASYNCIO
+#    define CONFIG_PUMBAA_MODULE_UASYNCIO                   0
+#endif
+
+#ifndef CONFIG_PUMBAA_SOCKET_ADDRESS_CACHE_MAX
+#    define CONFIG_PUMBAA_SOCKET_ADDRESS_CACHE_MAX          4
+#endif
+
 #ifndef CONFIG_PUMBAA_MODULE_SSL
 #    if defined(CONFIG_MINIMAL_SYSTEM)
 #        define CONFIG_PUMBAA_MODULE_SSL                    0
@@ -433,6 +497,30 @@
 #    endif
 #endif
 
+#ifndef CONFIG_PUMBAA_SSL_SESSION_CACHE
+#    if CONFIG_PUMBAA_MODULE_SSL == 1 && defined(ARCH_ESP32)
+#        define CONFIG_PUMBAA_SSL_SESSION_CACHE             1
+#    else
+#        define CONFIG_PUMBAA_SSL_SESSION_CACHE             0
+#    endif
+#endif
+
+#ifndef CONFIG_PUMBAA_SSL_LOW_RAM
+#    if CONFIG_PUMBAA_MODULE_SSL == 1 && defined(ARCH_ESP32)
+#        define CONFIG_PUMBAA_SSL_LOW_RAM                   1
+#    else
+#        define CONFIG_PUMBAA_SSL_LOW_RAM                   0
+#    endif
+#endif
+
+#ifndef CONFIG_PUMBAA_SSL_CERT_CACHE_MAX
+#    define CONFIG_PUMBAA_SSL_CERT_CACHE_MAX                4
+#endif
+
+#ifndef CONFIG_PUMBAA_SSL_MAX_FRAGMENT_LENGTH
+#    define CONFIG_PUMBAA_SSL_MAX_FRAGMENT_LENGTH           4096
+#endif
+
 #ifndef CONFIG_PUMBAA_EMACS
 #    if defined(CONFIG_MINIMAL_SYSTEM)
 #        define CONFIG_PUMBAA_EMACS                         0
@@ -447,6 +535,10 @@
  * Validate the configuration.
  */
 
+#if (CONFIG_PUMBAA_THREAD_TABLE_SIZE & (CONFIG_PUMBAA_THREAD_TABLE_SIZE - 1)) != 0
+#    error "CONFIG_PUMBAA_THREAD_TABLE_SIZE must be a power of two."
+#endif
+
 #if CONFIG_PUMBAA_THRD == 1 && MICROPY_PY_THREAD == 0
 #    error "MICROPY_PY_THREAD must be 1 when CONFIG_PUMBAA_THRD is 1."
 #endif
@@ -455,6 +547,14 @@
 #    error "MICROPY_PY_THREAD must be 1 when CONFIG_PUMBAA_HTTP_SERVER is 1."
 #endif
 
+#if CONFIG_PUMBAA_BYTECODE_CACHE == 1 && MICROPY_PY_UZLIB == 0
+#    error "MICROPY_PY_UZLIB must be 1 when CONFIG_PUMBAA_BYTECODE_CACHE is 1."
+#endif
+
+#if CONFIG_PUMBAA_MODULE_UASYNCIO == 1 && (CONFIG_PUMBAA_MODULE_SOCKET == 0 || CONFIG_PUMBAA_MODULE_SELECT == 0)
+#    error "CONFIG_PUMBAA_MODULE_SOCKET and CONFIG_PUMBAA_MODULE_SELECT must be 1 when CONFIG_PUMBAA_MODULE_UASYNCIO is 1."
+#endif
+
 #if CONFIG_PUMBAA_HTTP_SERVER_WEBSOCKET == 1 && CONFIG_PUMBAA_HTTP_SERVER == 0
 #    error "CONFIG_PUMBAA_HTTP_SERVER must be 1 when CONFIG_PUMBAA_HTTP_SERVER_WEBSOCKET is 1."
 #endif
@@ -470,6 +570,89 @@ extern const struct _mp_obj_module_t module_inet;
 extern const struct _mp_obj_module_t module_text;
 extern const struct _mp_obj_module_t module_board;
 
+/**
+ * Python callbacks scheduled by interrupt handlers, called by the VM
+ * between bytecodes.
+ */
+struct sched_port_item_t {
+    void *function;
+    void *arg;
+};
+
+extern volatile int sched_port_pending;
+
+/**
+ * Schedule given function to be called by the VM. It is called
+ * without arguments if arg is MP_OBJ_NULL. May only be called from
+ * an interrupt handler, or with the system lock taken. Returns zero(0)
+ * or negative error code if the queue is full.
+ */
+int sched_port_schedule_isr(void *function, void *arg);
+
+/**
+ * Call all scheduled functions.
+ */
+void sched_port_run(void);
+
+#define MICROPY_VM_HOOK_LOOP                    \
+    if (sched_port_pending) {                   \
+        sched_port_run();                       \
+    }
+
+#define MICROPY_VM_HOOK_RETURN MICROPY_VM_HOOK_LOOP
+
+#if CONFIG_PUMBAA_BYTECODE_CACHE == 1
+
+struct _mp_raw_code_t;
+
+/**
+ * Load given Python source file from the bytecode cache, or compile
+ * it and store the bytecode in the cache. Returns the raw code, or
+ * NULL to compile the source without the cache.
+ */
+struct _mp_raw_code_t *bytecode_cache_port_load(const char *path_p);
+
+/**
+ * Get the number of cache hits and misses since startup.
+ */
+void bytecode_cache_port_get_info(unsigned long *hits_p,
+                                  unsigned long *misses_p);
+
+#    define MICROPY_PERSISTENT_CODE_SAVE                  (1)
+#    define MICROPY_PERSISTENT_CODE_SAVE_FILE             (0)
+#    define MICROPY_PORT_IMPORT_LOAD_RAW_CODE(path_p)   \
+    bytecode_cache_port_load(path_p)
+#endif
+
+#if CONFIG_PUMBAA_IMPORT_STAT_CACHE == 1
+
+/**
+ * Forget all cached directory listings used to resolve imports. Must
+ * be called when files or directories are created, removed or
+ * renamed. Only the Python modules call it, so enable the cache only
+ * if no C code changes the directories in sys.path.
+ */
+void port_import_stat_cache_invalidate(void);
+
+/**
+ * Get the number of import lookups served from a cached directory
+ * listing and the number of directories read.
+ */
+void port_import_stat_cache_get_info(unsigned long *hits_p,
+                                     unsigned long *misses_p);
+
+#    define PORT_IMPORT_STAT_CACHE_INVALIDATE() \
+    port_import_stat_cache_invalidate()
+#else
+#    define PORT_IMPORT_STAT_CACHE_INVALIDATE()
+#endif
+
+#if MICROPY_PY_THREAD == 1
+#    define MICROPY_PORT_MEM_INFO module_thread_mem_info();
+#else
+#    define MODULE_THREAD_PARK(statement) statement
+#endif
+
 #ifndef MICROPY_PORT_BUILTIN_MODULES_EXTRA
 #    define MICROPY_PORT_BUILTIN_MODULES_EXTRA
 #endif
@@ -492,6 +675,13 @@ extern const struct _mp_obj_module_t module_board;
 #    define PORT_BUILTIN_MODULE_WEAK_LINKS_SOCKET
 #endif
 
+#if MICROPY_PY_UERRNO == 1
+#    define PORT_BUILTIN_MODULE_WEAK_LINKS_ERRNO                        \
+    { MP_OBJ_NEW_QSTR(MP_QSTR_errno), (mp_obj_t)&mp_module_uerrno },
+#else
+#    define PORT_BUILTIN_MODULE_WEAK_LINKS_ERRNO
+#endif
+
 #if CONFIG_PUMBAA_MODULE_SELECT == 1
 #    define PORT_BUILTIN_MODULE_SELECT                                  \
     { MP_ROM_QSTR(MP_QSTR_uselect), MP_ROM_PTR(&mp_module_uselect) },
@@ -529,6 +719,7 @@ extern const struct _mp_obj_module_t module_board;
 #define MICROPY_PORT_BUILTIN_MODULE_WEAK_LINKS                          \
     { MP_OBJ_NEW_QSTR(MP_QSTR_binascii), (mp_obj_t)&mp_module_ubinascii }, \
     { MP_OBJ_NEW_QSTR(MP_QSTR_collections), (mp_obj_t)&mp_module_collections }, \
+        PORT_BUILTIN_MODULE_WEAK_LINKS_ERRNO                            \
     { MP_OBJ_NEW_QSTR(MP_QSTR_hashlib), (mp_obj_t)&mp_module_uhashlib }, \
     { MP_OBJ_NEW_QSTR(MP_QSTR_io), (mp_obj_t)&mp_module_io },           \
     { MP_OBJ_NEW_QSTR(MP_QSTR_json), (mp_obj_t)&mp_module_ujson },      \
@@ -551,6 +742,8 @@ extern const struct _mp_obj_module_t module_board;
 #define MICROPY_PORT_ROOT_POINTERS \
     mp_obj_t keyboard_interrupt_obj; \
     const char *readline_hist[8]; \
+    struct sched_port_item_t sched_port_queue[CONFIG_PUMBAA_SCHED_QUEUE_LENGTH]; \
+    mp_obj_t import_stat_cache; \
     MICROPY_PORT_ROOT_POINTERS_EXTRA
 
 //////////////////////////////////////////
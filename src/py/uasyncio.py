@@ -0,0 +1,443 @@
+#
+# @section License
+#
+# The MIT License (MIT)
+#
+# Copyright (c) 2016-2017, Erik Moqvist
+#
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation
+# files (the "Software"), to deal in the Software without
+# restriction, including without limitation the rights to use, copy,
+# modify, merge, publish, distribute, sublicense, and/or sell copies
+# of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+# BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+# ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+# CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+# This file is part of the Pumbaa project.
+#
+"""Cooperative event loop running coroutines on a single thread.
+
+Coroutines waiting for a Simba channel (socket, queue, event, CAN or
+UART) are parked in a single ``select.poll`` object, which in turn
+waits in ``chan_list_poll()``. Many connections can therefore be
+served using only the stack of the thread running the loop.
+
+A channel can have one reader and one writer waiting at the same
+time. Stream sockets are non-blocking, so a read never blocks the
+loop.
+
+"""
+
+import sys
+import time
+import select
+import socket
+
+try:
+    from uerrno import EAGAIN
+except ImportError:
+    EAGAIN = 11
+
+
+class _Sleep(object):
+
+    def __init__(self, delay):
+        self.delay = delay
+
+
+class IORead(object):
+    """Yield an instance of this class to wait for given channel to
+    become readable.
+
+    """
+
+    def __init__(self, chan):
+        self.chan = chan
+
+
+class IOWrite(IORead):
+    """Yield an instance of this class to wait for given channel to
+    become writable.
+
+    """
+
+    pass
+
+
+class EventLoop(object):
+
+    def __init__(self):
+        self._runq = []
+        self._timers = []
+        self._waiting = {}
+        self._poll = select.poll()
+        self._stopped = False
+
+    def time(self):
+        return time.time()
+
+    def create_task(self, coro):
+        self._runq.append((coro, None))
+
+        return coro
+
+    def call_soon(self, coro, value=None):
+        self._runq.append((coro, value))
+
+    def call_later(self, delay, coro):
+        self.call_at(self.time() + delay, coro)
+
+    def call_at(self, when, coro):
+        # Keep the timer list sorted on expiry time. Timers with the
+        # same expiry time run in insertion order.
+        i = len(self._timers)
+
+        while i > 0 and self._timers[i - 1][0] > when:
+            i -= 1
+
+        self._timers.insert(i, (when, coro))
+
+    def _wait(self, coro, chan, eventmask):
+        # Channels are not hashable, use their identity as key. Each
+        # entry is a list of the channel, its reader and its writer.
+        waiters = self._waiting.get(id(chan))
+        index = 1 if eventmask == select.POLLIN else 2
+
+        if waiters is None:
+            waiters = [chan, None, None]
+            waiters[index] = coro
+            self._waiting[id(chan)] = waiters
+            self._poll.register(chan, eventmask)
+        elif waiters[index] is not None:
+            raise OSError('channel already waited on')
+        else:
+            waiters[index] = coro
+            self._poll.modify(chan, self._eventmask(waiters))
+
+    def _eventmask(self, waiters):
+        eventmask = 0
+
+        if waiters[1] is not None:
+            eventmask |= select.POLLIN
+
+        if waiters[2] is not None:
+            eventmask |= select.POLLOUT
+
+        return eventmask
+
+    def _step(self, coro, value):
+        try:
+            request = coro.send(value)
+        except StopIteration:
+            return
+        except Exception as e:
+            # Report the failed task and drop it, so the other tasks
+            # keep running.
+            print('Task {} failed:'.format(coro))
+            sys.print_exception(e)
+            return
+
+        if isinstance(request, IOWrite):
+            self._wait(coro, request.chan, select.POLLOUT)
+        elif isinstance(request, IORead):
+            self._wait(coro, request.chan, select.POLLIN)
+        elif isinstance(request, _Sleep):
+            self.call_later(request.delay, coro)
+        else:
+            # A yielded coroutine is started as a new task. The
+            # yielding coroutine is rescheduled immediately.
+            if request is not None:
+                self.create_task(request)
+
+            self.call_soon(coro)
+
+    def _expire_timers(self):
+        now = self.time()
+
+        while self._timers and self._timers[0][0] <= now:
+            self.call_soon(self._timers.pop(0)[1])
+
+    def _poll_channels(self):
+        if not self._waiting:
+            if self._runq or not self._timers:
+                return
+
+            delay = self._timers[0][0] - self.time()
+
+            if delay > 0:
+                time.sleep(delay)
+
+            return
+
+        if self._runq:
+            timeout = 0
+        elif self._timers:
+            timeout = max(0, self._timers[0][0] - self.time())
+        else:
+            timeout = None
+
+        for chan, revents in self._poll.ipoll(timeout):
+            waiters = self._waiting[id(chan)]
+
+            # A hang up wakes both the reader and the writer.
+            if revents & (select.POLLIN | select.POLLHUP) and waiters[1]:
+                self.call_soon(waiters[1])
+                waiters[1] = None
+
+            if revents & (select.POLLOUT | select.POLLHUP) and waiters[2]:
+                self.call_soon(waiters[2])
+                waiters[2] = None
+
+            eventmask = self._eventmask(waiters)
+
+            if eventmask == 0:
+                self._poll.unregister(chan)
+                del self._waiting[id(chan)]
+            else:
+                self._poll.modify(chan, eventmask)
+
+    def run_once(self):
+        """Run all runnable coroutines once, then wait for a timer to
+        expire or a channel to become ready. Returns False if there
+        is nothing left to run.
+
+        """
+
+        self._expire_timers()
+        runq = self._runq
+        self._runq = []
+
+        for coro, value in runq:
+            self._step(coro, value)
+
+        if not (self._runq or self._timers or self._waiting):
+            return False
+
+        # Do not wait for channels once stopped.
+        if not self._stopped:
+            self._poll_channels()
+
+        return True
+
+    def run_forever(self):
+        self._stopped = False
+
+        while not self._stopped:
+            if not self.run_once():
+                break
+
+    def run_until_complete(self, coro):
+        """Run the loop until given coroutine returns, and return its
+        value. An exception raised by the coroutine is raised.
+
+        """
+
+        result = []
+        error = []
+
+        def wrapper():
+            try:
+                result.append((yield from coro))
+            except Exception as e:
+                error.append(e)
+
+            self.stop()
+
+        self.create_task(wrapper())
+        self.run_forever()
+
+        if error:
+            raise error[0]
+
+        if result:
+            return result[0]
+
+    def stop(self):
+        self._stopped = True
+
+    def close(self):
+        pass
+
+
+_event_loop = None
+
+
+def get_event_loop():
+    global _event_loop
+
+    if _event_loop is None:
+        _event_loop = EventLoop()
+
+    return _event_loop
+
+
+def sleep(secs):
+    yield _Sleep(secs)
+
+
+def sleep_ms(ms):
+    yield _Sleep(ms / 1000)
+
+
+def wait_readable(chan):
+    yield IORead(chan)
+
+
+def wait_writable(chan):
+    yield IOWrite(chan)
+
+
+class StreamReader(object):
+    """Read from given non-blocking socket.
+
+    """
+
+    def __init__(self, sock):
+        self.sock = sock
+
+    def _recv(self, recv, arg, eof):
+        # A socket without data that woke up the poller has reached
+        # the end of stream.
+        for _ in range(2):
+            try:
+                return recv(arg)
+            except OSError as e:
+                if e.args[0] != EAGAIN:
+                    raise
+
+            yield IORead(self.sock)
+
+        return eof
+
+    def read(self, n=-1):
+        if n == -1:
+            n = 1024
+
+        return (yield from self._recv(self.sock.recv, n, b''))
+
+    def readinto(self, buf):
+        return (yield from self._recv(self.sock.recv_into, buf, 0))
+
+    def readexactly(self, n):
+        buf = b''
+
+        while len(buf) < n:
+            data = yield from self.read(n - len(buf))
+
+            if not data:
+                break
+
+            buf += data
+
+        return buf
+
+    def readline(self):
+        line = b''
+
+        while not line.endswith(b'\n'):
+            data = yield from self.read(1)
+
+            if not data:
+                break
+
+            line += data
+
+        return line
+
+    def aclose(self):
+        yield
+        self.sock.close()
+
+
+class StreamWriter(object):
+
+    def __init__(self, sock):
+        self.sock = sock
+
+    def awrite(self, buf):
+        yield IOWrite(self.sock)
+        self.sock.sendall(buf)
+
+    def awritev(self, bufs):
+        yield IOWrite(self.sock)
+        self.sock.sendv(bufs)
+
+    def aclose(self):
+        yield IOWrite(self.sock)
+        self.sock.close()
+
+
+def _connect(sock, address):
+    """Connect given socket without blocking the loop. Simba sockets
+    only connect blocking, so the socket is connected by a helper
+    thread, which the loop waits for on an event channel. The socket
+    is connected by the calling thread if threads are not supported.
+
+    """
+
+    try:
+        import _thread
+        from sync import Event
+    except ImportError:
+        sock.connect(address)
+        return
+
+    event = Event()
+    error = []
+
+    def connect():
+        try:
+            sock.connect(address)
+        except Exception as e:
+            error.append(e)
+
+        event.write(0x1)
+
+    _thread.start_new_thread(connect, ())
+    yield IORead(event)
+    event.read(0x1)
+
+    if error:
+        raise error[0]
+
+
+def open_connection(host, port):
+    sock = socket.socket()
+    yield from _connect(sock, (host, port))
+    sock.setblocking(False)
+
+    return StreamReader(sock), StreamWriter(sock)
+
+
+def start_server(client_coro, host, port, backlog=10):
+    """Accept connections on given address and start one task running
+    ``client_coro(reader, writer)`` per connection.
+
+    """
+
+    listener = socket.socket()
+    listener.bind((host, port))
+    listener.listen(backlog)
+    loop = get_event_loop()
+
+    try:
+        while True:
+            yield IORead(listener)
+            sock, _ = listener.accept()
+            sock.setblocking(False)
+            loop.create_task(client_coro(StreamReader(sock),
+                                         StreamWriter(sock)))
+    finally:
+        listener.close()
@@ -38,6 +38,7 @@ if 'Linux' in os.uname().machine:
         "socket_suite",
         "ssl_suite",
         "thread_suite",
+        "uasyncio_suite",
         "adc_suite",
         "can_suite",
         "i2c_suite",
@@ -35,12 +35,17 @@
 
 #define CONFIG_THRD_STACK_HEAP                      1
 #define CONFIG_PUMBAA_CLASS_HTTP_SERVER             1
+#define CONFIG_PUMBAA_CLASS_HTTP_SERVER_STATIC_GZIP 1
+#define CONFIG_PUMBAA_MODULE_SSL                    1
+#define CONFIG_HTTP_SERVER_SSL                      1
 
-#define MICROPY_PORT_BUILTIN_MODULES_EXTRA                              \
-    { MP_ROM_QSTR(MP_QSTR_socket_stub), MP_ROM_PTR(&module_socket_stub) },
+#define MICROPY_PORT_BUILTIN_MODULES_EXTRA      \
+    SOCKET_STUB_BUILTIN_MODULE                  \
+    SSL_STUB_BUILTIN_MODULE
 
 #define MICROPY_PORT_ROOT_POINTERS_EXTRA        \
-    SOCKET_STUB_ROOT_POINTERS
+    SOCKET_STUB_ROOT_POINTERS                   \
+    SSL_STUB_ROOT_POINTERS
 
 /* Changes of the default Simba configuration. */
 #include "simba_config.h"
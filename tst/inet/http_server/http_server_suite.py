@@ -28,10 +28,14 @@
 # This file is part of the Pumbaa project.
 #
 
+import os
 import harness
-from inet import HttpServer, HttpServerWebSocket
+from inet import HttpServer, HttpServerStatic, HttpServerWebSocket
+from inet import HttpServerWebSocketGroup
 from harness import assert_raises
 import socket_stub
+import ssl_stub
+import ssl
 
 HTTP_SERVER = None
 
@@ -52,6 +56,10 @@ def on_index(connection, request):
     assert request.content_type == 'text/plain'
     assert request.authorization == 'foo'
     assert request.expect == 'CONTINUE'
+    assert request.header('Content-Type') == 'text/plain'
+    assert request.header('content-length') == 1
+    assert request.header('X-Unknown') is None
+    assert request.sec_websocket_key is None
 
     return ('Welcome!', )
 
@@ -68,6 +76,26 @@ def on_form(connection, request):
     return ('Form!', )
 
 
+def on_root(connection, request):
+    print('on_root({}, {})'.format(connection, request))
+    assert request.path == '/'
+
+    return ('Root!', )
+
+
+def on_form_get(connection, request):
+    print('on_form_get({}, {})'.format(connection, request))
+    assert request.action == HttpServer.GET
+
+    return ('Get form!', )
+
+
+def on_static(connection, request):
+    print('on_static({}, {})'.format(connection, request))
+
+    return (request.path, )
+
+
 def on_split(connection, request):
     print('on_split({}, {})'.format(connection, request))
     text = 'Welcome split!'
@@ -75,6 +103,30 @@ def on_split(connection, request):
     connection.socket_write(text)
 
 
+def on_stream(connection, request):
+    print('on_stream({}, {})'.format(connection, request))
+
+    def chunks():
+        yield 'Hello '
+        yield ''
+        yield b'world!'
+
+    if request.path == '/stream/length':
+        return (chunks(), HttpServer.RESPONSE_CODE_200_OK,
+                HttpServer.CONTENT_TYPE_TEXT_PLAIN, 12)
+    elif request.path == '/stream/error':
+        return (chunks(), 500, HttpServer.CONTENT_TYPE_TEXT_PLAIN)
+    else:
+        return (chunks(), HttpServer.RESPONSE_CODE_200_OK,
+                HttpServer.CONTENT_TYPE_TEXT_PLAIN)
+
+
+def on_file(connection, request):
+    print('on_file({}, {})'.format(connection, request))
+
+    return (open('stream.txt', 'r'), )
+
+
 def on_bad_arguments(connection, request):
     print('on_bad_arguments({}, {})'.format(connection, request))
     return ()
@@ -97,6 +149,46 @@ def on_websocket_echo(connection, request):
     assert ws.read_into(message) == 4
     ws.write(message[:4])
 
+    # Websocket read_frame_into().
+    assert ws.read_frame_into(message) == (HttpServerWebSocket.OPCODE_BINARY, 4)
+    assert message[:4] == b'456\x00'
+
+    # A truncated frame payload.
+    message = bytearray(4)
+    assert ws.read_frame_into(message) == (HttpServerWebSocket.OPCODE_BINARY, 6)
+    assert message == b'abcd'
+
+    # Broadcast to a group.
+    group = HttpServerWebSocketGroup()
+    group.add(ws)
+    assert len(group) == 1
+    assert group.broadcast(b'hello') == 1
+
+    with assert_raises(ValueError, "bad opcode"):
+        group.broadcast(b'hello', 0x10)
+
+    with assert_raises(ValueError, "control frame too long"):
+        group.broadcast(126 * b'x', HttpServerWebSocket.OPCODE_PING)
+
+    group.remove(ws)
+    assert len(group) == 0
+    assert group.broadcast(b'hello') == 0
+
+    with assert_raises(TypeError, "expected a WebSocket"):
+        group.add(None)
+
+    # The WebSocket is closed when this callback returns.
+    WEBSOCKET_GROUP.add(ws)
+    global WEBSOCKET_CONNECTION
+    global WEBSOCKET
+    WEBSOCKET_CONNECTION = connection
+    WEBSOCKET = ws
+
+
+WEBSOCKET_GROUP = HttpServerWebSocketGroup()
+WEBSOCKET_CONNECTION = None
+WEBSOCKET = None
+
 
 def simple_http_request(request,
                         response_header=None,
@@ -122,6 +214,7 @@ def test_print():
     print(HttpServer)
     print(HttpServer("127.0.0.1", 80, [], on_404_not_found))
     print(HttpServerWebSocket)
+    print(HttpServerStatic('www'))
 
 
 def test_start():
@@ -129,12 +222,35 @@ def test_start():
         ('/index.html', on_index),
         ('/form.html', on_form),
         ('/split.html', on_split),
+        ('/stream', on_stream),
+        ('/file.txt', on_file),
+        ('/www/', HttpServerStatic('www')),
         ('/websocket/echo', on_websocket_echo),
-        ('/bad_arguments.html', on_bad_arguments)
+        ('/bad_arguments.html', on_bad_arguments),
+        ('/', on_root, HttpServer.GET, True),
+        ('/form.html', on_form_get, HttpServer.GET)
     ]
 
     global HTTP_SERVER
-    HTTP_SERVER = HttpServer("192.168.0.1", 8080, routes, on_404_not_found)
+    HTTP_SERVER = HttpServer("192.168.0.1",
+                             8080,
+                             routes,
+                             on_404_not_found,
+                             max_requests=3,
+                             idle_timeout=0.05,
+                             workers=1,
+                             queue=1)
+    HTTP_SERVER.add_route(('/static/', on_static))
+
+    with assert_raises(ValueError, "workers must be at least 1"):
+        HttpServer("192.168.0.1", 8080, [], on_404_not_found, workers=0)
+
+    with assert_raises(ValueError, "queue must be at least 0"):
+        HttpServer("192.168.0.1", 8080, [], on_404_not_found, queue=-1)
+
+    with assert_raises(ValueError, "expected route tuple of length 2 to 4"):
+        HTTP_SERVER.add_route(('/foo', ))
+
     HTTP_SERVER.start()
 
 
@@ -147,7 +263,8 @@ def test_index():
               "Content-Type: text/plain\r\n" \
               "Authorization: foo\r\n" \
               "Expect: CONTINUE\r\n" \
-              "\r\n"
+              "\r\n" \
+              "x"
     response_header = "HTTP/1.1 200 OK\r\n" \
                       "Content-Type: text/html\r\n" \
                       "Content-Length: 8\r\n" \
@@ -190,6 +307,133 @@ def test_form():
 
     assert socket_stub.reset_failed() == 0
 
+    # The closed WebSocket is removed from the group instead of being
+    # written to.
+    assert len(WEBSOCKET_GROUP) == 1
+    assert WEBSOCKET_GROUP.broadcast(b'late') == 0
+    assert len(WEBSOCKET_GROUP) == 0
+
+    with assert_raises(OSError, "connection closed"):
+        WEBSOCKET_CONNECTION.socket_write(b'late')
+
+
+def test_routes():
+    # Exact match of the root path.
+    request = "GET / HTTP/1.1\r\n" \
+              "\r\n"
+    response_header = "HTTP/1.1 200 OK\r\n" \
+                      "Content-Type: text/html\r\n" \
+                      "Content-Length: 5\r\n" \
+                      "\r\n"
+    simple_http_request(request, response_header, "Root!")
+
+    # The GET specific route.
+    request = "GET /form.html HTTP/1.1\r\n" \
+              "\r\n"
+    response_header = "HTTP/1.1 200 OK\r\n" \
+                      "Content-Type: text/html\r\n" \
+                      "Content-Length: 9\r\n" \
+                      "\r\n"
+    simple_http_request(request, response_header, "Get form!")
+
+    # Prefix match.
+    request = "GET /static/app.js HTTP/1.1\r\n" \
+              "\r\n"
+    response_header = "HTTP/1.1 200 OK\r\n" \
+                      "Content-Type: text/html\r\n" \
+                      "Content-Length: 14\r\n" \
+                      "\r\n"
+    simple_http_request(request, response_header, "/static/app.js")
+
+
+def test_keep_alive():
+    # Two pipelined requests on one connection. The content of the
+    # first request is not read by the callback and is discarded.
+    request = "GET /index.html HTTP/1.1\r\n" \
+              "Content-Length: 1\r\n" \
+              "Content-Type: text/plain\r\n" \
+              "Authorization: foo\r\n" \
+              "Expect: CONTINUE\r\n" \
+              "\r\n" \
+              "x" \
+              "GET /static/keep.js HTTP/1.1\r\n" \
+              "Connection: close\r\n" \
+              "\r\n"
+    response_header_1 = "HTTP/1.1 200 OK\r\n" \
+                        "Content-Type: text/html\r\n" \
+                        "Content-Length: 8\r\n" \
+                        "\r\n"
+    response_header_2 = "HTTP/1.1 200 OK\r\n" \
+                        "Content-Type: text/html\r\n" \
+                        "Content-Length: 15\r\n" \
+                        "\r\n"
+
+    socket_stub.set_recv([bytes(char, 'ascii') for char in request])
+    socket_stub.set_send([
+        bytes(response_header_1, 'ascii'),
+        b'Welcome!',
+        bytes(response_header_2, 'ascii'),
+        b'/static/keep.js'
+    ])
+    socket_stub.set_close(0)
+    socket_stub.set_accept(0)
+    socket_stub.wait_closed()
+    assert socket_stub.reset_failed() == 0
+
+
+def test_bad_requests():
+    # A too long field that is ignored is accepted, while an
+    # unsupported method is answered before the connection is closed.
+    request = "GET /index.html HTTP/1.1\r\n" \
+              "\r\n" \
+              "GET /index.html HTTP/1.1\r\n" \
+              "User-Agent: " + 150 * "x" + "\r\n" \
+              "\r\n" \
+              "DELETE /index.html HTTP/1.1\r\n" \
+              "\r\n"
+    response_header = "HTTP/1.1 200 OK\r\n" \
+                      "Content-Type: text/html\r\n" \
+                      "Content-Length: 8\r\n" \
+                      "\r\n"
+    response_error = "\r\n" \
+                     "Content-Length: 0\r\n" \
+                     "Connection: close\r\n" \
+                     "\r\n"
+
+    socket_stub.set_recv([bytes(char, 'ascii') for char in request])
+    socket_stub.set_send([
+        bytes(response_header, 'ascii'),
+        b'Welcome!',
+        bytes(response_header, 'ascii'),
+        b'Welcome!',
+        b'HTTP/1.1 ',
+        b'501 Not Implemented',
+        bytes(response_error, 'ascii')
+    ])
+    socket_stub.set_close(0)
+    socket_stub.set_accept(0)
+    socket_stub.wait_closed()
+    assert socket_stub.reset_failed() == 0
+
+    # A too long request line.
+    request = "GET /index.html HTTP/1.1\r\n" \
+              "\r\n" \
+              "GET /" + 150 * "x" + " HTTP/1.1\r\n" \
+              "\r\n"
+
+    socket_stub.set_recv([bytes(char, 'ascii') for char in request])
+    socket_stub.set_send([
+        bytes(response_header, 'ascii'),
+        b'Welcome!',
+        b'HTTP/1.1 ',
+        b'414 URI Too Long',
+        bytes(response_error, 'ascii')
+    ])
+    socket_stub.set_close(0)
+    socket_stub.set_accept(0)
+    socket_stub.wait_closed()
+    assert socket_stub.reset_failed() == 0
+
 
 def test_split():
     # Test data.
@@ -206,6 +450,201 @@ def test_split():
     simple_http_request(request, response_header, response_body)
 
 
+def test_stream():
+    # Chunked transfer encoding.
+    request = "GET /stream HTTP/1.1\r\n" \
+              "\r\n"
+    response_header = "HTTP/1.1 200 OK\r\n" \
+                      "Content-Type: text/plain\r\n" \
+                      "Transfer-Encoding: chunked\r\n" \
+                      "\r\n"
+
+    socket_stub.set_recv([bytes(char, 'ascii') for char in request])
+    socket_stub.set_send([
+        bytes(response_header, 'ascii'),
+        b'6\r\n', b'Hello ', b'\r\n',
+        b'6\r\n', b'world!', b'\r\n',
+        b'0\r\n', b'\r\n'
+    ])
+    socket_stub.set_close(0)
+    socket_stub.set_accept(0)
+    socket_stub.wait_closed()
+    assert socket_stub.reset_failed() == 0
+
+    # A response code without a Simba constant.
+    request = "GET /stream/error HTTP/1.1\r\n" \
+              "\r\n"
+    response_header = "HTTP/1.1 500 Internal Server Error\r\n" \
+                      "Content-Type: text/plain\r\n" \
+                      "Transfer-Encoding: chunked\r\n" \
+                      "\r\n"
+
+    socket_stub.set_recv([bytes(char, 'ascii') for char in request])
+    socket_stub.set_send([
+        bytes(response_header, 'ascii'),
+        b'6\r\n', b'Hello ', b'\r\n',
+        b'6\r\n', b'world!', b'\r\n',
+        b'0\r\n', b'\r\n'
+    ])
+    socket_stub.set_close(0)
+    socket_stub.set_accept(0)
+    socket_stub.wait_closed()
+    assert socket_stub.reset_failed() == 0
+
+    # Content length given by the callback.
+    request = "GET /stream/length HTTP/1.1\r\n" \
+              "\r\n"
+    response_header = "HTTP/1.1 200 OK\r\n" \
+                      "Content-Type: text/plain\r\n" \
+                      "Content-Length: 12\r\n" \
+                      "\r\n"
+
+    socket_stub.set_recv([bytes(char, 'ascii') for char in request])
+    socket_stub.set_send([
+        bytes(response_header, 'ascii'),
+        b'Hello ',
+        b'world!'
+    ])
+    socket_stub.set_close(0)
+    socket_stub.set_accept(0)
+    socket_stub.wait_closed()
+    assert socket_stub.reset_failed() == 0
+
+
+def test_file():
+    try:
+        with open('stream.txt', 'w') as fout:
+            fout.write('File content!')
+    except OSError:
+        raise harness.TestCaseSkippedError()
+
+    request = "GET /file.txt HTTP/1.1\r\n" \
+              "\r\n"
+    response_header = "HTTP/1.1 200 OK\r\n" \
+                      "Content-Type: text/html\r\n" \
+                      "Content-Length: 13\r\n" \
+                      "\r\n"
+
+    simple_http_request(request, response_header, "File content!")
+
+
+def test_static():
+    try:
+        try:
+            os.mkdir('www')
+        except OSError:
+            pass
+
+        with open('www/app.js', 'w') as fout:
+            fout.write('var x = 1;\n')
+    except OSError:
+        raise harness.TestCaseSkippedError()
+
+    # The second request has the ETag of the first response. If-None-Match
+    # is not known for the first request on a connection, as it is
+    # parsed by Simba, so only kept alive requests get 304.
+    request = "GET /www/app.js HTTP/1.1\r\n" \
+              "\r\n" \
+              "GET /www/app.js HTTP/1.1\r\n" \
+              "Accept-Encoding: gzip, deflate\r\n" \
+              "If-None-Match: \"b-bc700ee5\"\r\n" \
+              "Connection: close\r\n" \
+              "\r\n"
+    response_header = "HTTP/1.1 200 OK\r\n" \
+                      "Content-Type: application/javascript\r\n" \
+                      "Content-Length: 11\r\n" \
+                      "ETag: \"b-bc700ee5\"\r\n" \
+                      "\r\n"
+    response_not_modified = "HTTP/1.1 304 Not Modified\r\n" \
+                            "ETag: \"b-bc700ee5\"\r\n" \
+                            "\r\n"
+
+    socket_stub.set_recv([bytes(char, 'ascii') for char in request])
+    socket_stub.set_send([
+        bytes(response_header, 'ascii'),
+        b'var x = 1;\n',
+        bytes(response_not_modified, 'ascii')
+    ])
+    socket_stub.set_close(0)
+    socket_stub.set_accept(0)
+    socket_stub.wait_closed()
+    assert socket_stub.reset_failed() == 0
+
+    # A file with a changed size gets a new ETag.
+    with open('www/app.js', 'w') as fout:
+        fout.write('var x = 10;\n')
+
+    request = "GET /www/app.js HTTP/1.1\r\n" \
+              "\r\n"
+    response_header = "HTTP/1.1 200 OK\r\n" \
+                      "Content-Type: application/javascript\r\n" \
+                      "Content-Length: 12\r\n" \
+                      "ETag: \"c-28038839\"\r\n" \
+                      "\r\n"
+
+    simple_http_request(request, response_header, 'var x = 10;\n')
+
+    # The query string is not part of the file path.
+    request = "GET /www/app.js?v=3 HTTP/1.1\r\n" \
+              "\r\n"
+
+    simple_http_request(request, response_header, 'var x = 10;\n')
+
+    # The precompressed file is only served once Accept-Encoding is
+    # known, that is, not for the first request on a connection.
+    with open('www/style.css', 'w') as fout:
+        fout.write('body{}\n')
+
+    with open('www/style.css.gz', 'w') as fout:
+        fout.write('gzipped\n')
+
+    request = "GET /www/style.css HTTP/1.1\r\n" \
+              "Accept-Encoding: gzip\r\n" \
+              "\r\n" \
+              "GET /www/style.css HTTP/1.1\r\n" \
+              "Accept-Encoding: gzip\r\n" \
+              "Connection: close\r\n" \
+              "\r\n"
+    response_header = "HTTP/1.1 200 OK\r\n" \
+                      "Content-Type: text/css\r\n" \
+                      "Content-Length: 7\r\n" \
+                      "ETag: \"7-208268b2\"\r\n" \
+                      "\r\n"
+    response_header_gzip = "HTTP/1.1 200 OK\r\n" \
+                           "Content-Type: text/css\r\n" \
+                           "Content-Length: 8\r\n" \
+                           "Content-Encoding: gzip\r\n" \
+                           "Vary: Accept-Encoding\r\n" \
+                           "ETag: \"8-e55aa919\"\r\n" \
+                           "\r\n"
+
+    socket_stub.set_recv([bytes(char, 'ascii') for char in request])
+    socket_stub.set_send([
+        bytes(response_header, 'ascii'),
+        b'body{}\n',
+        bytes(response_header_gzip, 'ascii'),
+        b'gzipped\n'
+    ])
+    socket_stub.set_close(0)
+    socket_stub.set_accept(0)
+    socket_stub.wait_closed()
+    assert socket_stub.reset_failed() == 0
+
+    # Missing file.
+    request = "GET /www/missing.js HTTP/1.1\r\n" \
+              "\r\n"
+    response = "HTTP/1.1 404 Not Found\r\n" \
+               "Content-Length: 0\r\n" \
+               "\r\n"
+
+    socket_stub.set_recv([bytes(char, 'ascii') for char in request])
+    socket_stub.set_send([bytes(response, 'ascii')])
+    socket_stub.set_close(0)
+    socket_stub.set_accept(0)
+    socket_stub.wait_closed()
+    assert socket_stub.reset_failed() == 0
+
+
 def test_no_route():
     # Test data.
     request = "GET /missing.html HTTP/1.1\r\n" \
@@ -250,13 +689,17 @@ def test_websocket_echo():
         [bytes(char, 'ascii') for char in request]
         + [b'\x81\x84', b'\x00\x00\x00\x00', b'123\x00']
         + [b'\x81\x84', b'\x00\x00\x00\x00', b'123\x00']
+        + [b'\x82\x84', b'\x00\x00\x00\x00', b'456\x00']
+        + [b'\x82\x86', b'\x00\x00\x00\x00', b'abcd', b'ef']
     )
     socket_stub.set_send([
         bytes(response, 'ascii'),
         b'\x81\x04',
         b'123\x00',
         b'\x81\x04',
-        b'123\x00'
+        b'123\x00',
+        b'\x81\x05',
+        b'hello'
     ])
     socket_stub.set_close(0)
 
@@ -268,19 +711,95 @@ def test_websocket_echo():
 
     assert socket_stub.reset_failed() == 0
 
+    # The closed WebSocket is removed from the group instead of being
+    # written to.
+    assert len(WEBSOCKET_GROUP) == 1
+    assert WEBSOCKET_GROUP.broadcast(b'late') == 0
+    assert len(WEBSOCKET_GROUP) == 0
+
+    with assert_raises(OSError, "connection closed"):
+        WEBSOCKET_CONNECTION.socket_write(b'late')
+
+    with assert_raises(OSError, "connection closed"):
+        WEBSOCKET.write(b'late')
+
+
+def test_statistics():
+    statistics = HTTP_SERVER.statistics()
+    print(statistics)
+
+    assert statistics.requests > 0
+    assert statistics.rejected == 0
+    assert statistics.queue_depth == 0
+    assert statistics.queue_depth_max == 0
+    assert statistics.latency_average <= statistics.latency_max
+
 
 def test_stop():
     HTTP_SERVER.stop()
 
 
+def test_ssl_keep_alive():
+    # The second request on a connection wrapped in SSL is only seen
+    # if the wrapped socket is polled, as the SSL channel is never
+    # woken up.
+    server = HttpServer("192.168.0.1",
+                        8443,
+                        [('/index.html', on_index)],
+                        on_404_not_found,
+                        max_requests=2,
+                        idle_timeout=0.05)
+
+    try:
+        server.wrap_ssl(ssl.SSLContext(ssl.PROTOCOL_TLS))
+    except NotImplementedError:
+        raise harness.TestCaseSkippedError()
+
+    server.start()
+    ssl_stub.set_passthrough(True)
+
+    request = "GET /index.html HTTP/1.1\r\n" \
+              "\r\n" \
+              "GET /index.html HTTP/1.1\r\n" \
+              "Connection: close\r\n" \
+              "\r\n"
+    response_header = "HTTP/1.1 200 OK\r\n" \
+                      "Content-Type: text/html\r\n" \
+                      "Content-Length: 8\r\n" \
+                      "\r\n"
+
+    socket_stub.set_recv([bytes(char, 'ascii') for char in request])
+    socket_stub.set_send([
+        bytes(response_header, 'ascii'),
+        b'Welcome!',
+        bytes(response_header, 'ascii'),
+        b'Welcome!'
+    ])
+    socket_stub.set_close(0)
+    socket_stub.set_accept(0)
+    socket_stub.wait_closed()
+    assert socket_stub.reset_failed() == 0
+
+    ssl_stub.set_passthrough(False)
+    server.stop()
+
+
 TESTCASES = [
     (test_print, "test_print"),
     (test_start, "test_start"),
     (test_index, "test_index"),
     (test_form, "test_form"),
+    (test_routes, "test_routes"),
+    (test_keep_alive, "test_keep_alive"),
+    (test_bad_requests, "test_bad_requests"),
     (test_split, "test_split"),
+    (test_stream, "test_stream"),
+    (test_file, "test_file"),
+    (test_static, "test_static"),
     (test_no_route, "test_no_route"),
     (test_bad_arguments, "test_bad_arguments"),
     (test_websocket_echo, "test_websocket_echo"),
-    (test_stop, "test_stop")
+    (test_statistics, "test_statistics"),
+    (test_stop, "test_stop"),
+    (test_ssl_keep_alive, "test_ssl_keep_alive")
 ]
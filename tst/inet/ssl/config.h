@@ -40,6 +40,7 @@
 #define CONFIG_THRD_STACK_HEAP      1
 #define CONFIG_PUMBAA_MODULE_SOCKET 1
 #define CONFIG_PUMBAA_MODULE_SSL    1
+#define CONFIG_PUMBAA_SSL_SESSION_CACHE 1
 
 #define MICROPY_PORT_BUILTIN_MODULES_EXTRA      \
     SOCKET_STUB_BUILTIN_MODULE                  \
@@ -32,7 +32,9 @@ import harness
 from harness import assert_raises
 import ssl
 import socket
+import select
 import socket_stub
+import ssl_stub
 
 
 def test_print():
@@ -95,8 +97,111 @@ def test_server():
     assert ssl_sock.send(b'goodbye') == 7
 
 
+def test_poll():
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS)
+    sock = socket.socket()
+    sock.connect(('192.168.0.1', 8080))
+    ssl_sock = context.wrap_socket(sock)
+    ssl_sock.setblocking(False)
+
+    # No record is pending.
+    with assert_raises(OSError):
+        ssl_sock.recv(5)
+
+    # A record arrives on the wrapped socket.
+    socket_stub.set_recv(b'record')
+    poll = select.poll()
+    poll.register(ssl_sock)
+    assert poll.poll(0) == [(ssl_sock, select.POLLIN)]
+
+    buf = bytearray(5)
+    assert ssl_sock.recv_into(buf) == 5
+    assert buf == b'hello'
+    assert ssl_sock.write(b'hello') == 5
+    poll.unregister(ssl_sock)
+
+
+def test_session_cache():
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS)
+    assert context.session_cache_info() == (0, 0)
+
+    try:
+        context.set_session_cache(4, timeout=3600)
+    except NotImplementedError:
+        raise harness.TestCaseSkippedError()
+
+    with assert_raises(OSError, "session cache already set"):
+        context.set_session_cache(4)
+
+    assert context.session_cache_info() == (0, 0)
+
+    # Sessions are only written to a file on request.
+    with assert_raises(OSError, "no session cache file"):
+        context.save_session_cache()
+
+    # A miss followed by a hit.
+    assert ssl_stub.handshake(b'1') is False
+    assert ssl_stub.handshake(b'1') is True
+    assert ssl_stub.handshake(b'2') is False
+    assert context.session_cache_info() == (1, 2)
+
+    # Save and load the cache with wall clock time (2017-07-14).
+    ssl_stub.set_time(1500000000)
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS)
+    context.set_session_cache(4, path='sessions.bin')
+    assert ssl_stub.handshake(b'3') is False
+    context.save_session_cache()
+
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS)
+    context.set_session_cache(4, path='sessions.bin')
+    assert ssl_stub.handshake(b'3') is True
+    assert ssl_stub.handshake(b'4') is False
+    assert context.session_cache_info() == (1, 1)
+
+    # Expired sessions are not resumed.
+    ssl_stub.set_time(1500003601)
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS)
+    context.set_session_cache(4, timeout=3600, path='sessions.bin')
+    assert ssl_stub.handshake(b'3') is False
+    assert context.session_cache_info() == (0, 1)
+
+    # The age of the saved sessions is unknown without wall clock
+    # time, as they may have been saved before a restart.
+    ssl_stub.set_time(100)
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS)
+    context.set_session_cache(4, path='sessions.bin')
+    assert ssl_stub.handshake(b'3') is False
+    assert context.session_cache_info() == (0, 1)
+
+
+def test_low_ram():
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS)
+
+    try:
+        context.set_max_fragment_length(2048)
+    except NotImplementedError:
+        raise harness.TestCaseSkippedError()
+
+    with assert_raises(ValueError, "bad fragment length"):
+        context.set_max_fragment_length(3000)
+
+    # A compile time estimate, not a measurement. The record buffers
+    # are smaller than the two 16 kB buffers of a default mbedtls
+    # build, but fit the maximum fragment length.
+    total, buffers = ssl.connection_footprint_estimate()
+    print('Estimated SSL connection footprint:', total, buffers)
+    assert total > buffers
+    assert 2 * 4096 <= buffers < 2 * 16384
+
+    # No context uses a cached certificate.
+    assert ssl.flush_cert_cache() == 0
+
+
 TESTCASES = [
     (test_print, "test_print"),
     (test_client, "test_client"),
-    (test_server, "test_server")
+    (test_server, "test_server"),
+    (test_poll, "test_poll"),
+    (test_session_cache, "test_session_cache"),
+    (test_low_ram, "test_low_ram")
 ]
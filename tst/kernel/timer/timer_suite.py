@@ -62,6 +62,26 @@ def test_periodic_timer():
     timer.stop()
 
 
+def test_callback():
+    event = Event()
+    calls = []
+
+    def callback():
+        calls.append(len(calls))
+
+    timer = Timer(0.01, event, 0x1, callback=callback)
+    timer.start()
+    event.read(0x1)
+
+    # The callback is called by the VM, not from the interrupt.
+    i = 0
+
+    while not calls and i < 1000:
+        i += 1
+
+    assert calls == [0]
+
+
 def test_empty():
     Timer(1.0)
 
@@ -84,6 +104,7 @@ TESTCASES = [
     (test_help, "test_help"),
     (test_single_shot_timer, "test_single_shot_timer"),
     (test_periodic_timer, "test_periodic_timer"),
+    (test_callback, "test_callback"),
     (test_empty, "test_empty"),
     (test_bad_arguments, "test_bad_arguments")
 ]
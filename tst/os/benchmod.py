@@ -0,0 +1,108 @@
+#
+# @section License
+#
+# The MIT License (MIT)
+#
+# Copyright (c) 2016-2017, Erik Moqvist
+#
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation
+# files (the "Software"), to deal in the Software without
+# restriction, including without limitation the rights to use, copy,
+# modify, merge, publish, distribute, sublicense, and/or sell copies
+# of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+# BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+# ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+# CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+# This file is part of the Pumbaa project.
+#
+# Module imported both as source and as precompiled bytecode by
+# test_import_mpy_benchmark in os_suite.py.
+#
+
+
+VALUE = 1
+
+
+class Accumulator(object):
+
+    def __init__(self, start=0):
+        self.total = start
+        self.count = 0
+
+    def add(self, value):
+        self.total += value
+        self.count += 1
+
+        return self.total
+
+    def mean(self):
+        if self.count == 0:
+            return 0
+
+        return self.total / self.count
+
+
+def fibonacci(n):
+    a, b = 0, 1
+
+    for _ in range(n):
+        a, b = b, a + b
+
+    return a
+
+
+def histogram(values, buckets):
+    counts = [0] * buckets
+    low = min(values)
+    high = max(values)
+    width = (high - low) / buckets or 1
+
+    for value in values:
+        index = int((value - low) / width)
+
+        if index >= buckets:
+            index = buckets - 1
+
+        counts[index] += 1
+
+    return counts
+
+
+def format_table(rows):
+    widths = [max(len(str(cell)) for cell in column)
+              for column in zip(*rows)]
+    lines = []
+
+    for row in rows:
+        cells = [str(cell) + ' ' * (width - len(str(cell)))
+                 for cell, width in zip(row, widths)]
+        lines.append(' | '.join(cells))
+
+    return '\n'.join(lines)
+
+
+def parse_key_values(text):
+    result = {}
+
+    for line in text.split('\n'):
+        line = line.strip()
+
+        if not line or line.startswith('#'):
+            continue
+
+        key, _, value = line.partition('=')
+        result[key.strip()] = value.strip()
+
+    return result
@@ -30,6 +30,8 @@
 
 
 import os
+import sys
+import time
 import harness
 from harness import assert_raises
 
@@ -255,6 +257,248 @@ def test_system():
         os.system('')
 
 
+def test_import_benchmark():
+    """Import a 30 kB module from the file system. The time spent
+    reading the file is the import time minus the time to execute the
+    same source from memory.
+
+    """
+
+    line = '# ' + 60 * 'x' + '\n'
+    number_of_lines = 30000 // len(line)
+
+    with open("bigmod.py", "w") as fout:
+        for _ in range(number_of_lines):
+            fout.write(line)
+
+        fout.write("VALUE = 1\n")
+
+    start = time.time()
+    bigmod = __import__('bigmod')
+    import_time = time.time() - start
+
+    assert bigmod.VALUE == 1
+    del sys.modules['bigmod']
+
+    source = number_of_lines * line + "VALUE = 1\n"
+    start = time.time()
+    exec(source, {})
+    exec_time = time.time() - start
+
+    print('Imported {} bytes in {} s, of which {} s reading the file.'.format(
+        len(source),
+        import_time,
+        import_time - exec_time))
+
+    # Compare reading the file in chunks of the old lexer buffer size
+    # (20 bytes) and of the current one (512 bytes by default).
+    for chunk_size in [20, 512]:
+        buf = bytearray(chunk_size)
+        start = time.time()
+
+        with open("bigmod.py", "rb") as fin:
+            while fin.readinto(buf) > 0:
+                pass
+
+        print('Read the file in {} byte chunks in {} s.'.format(
+            chunk_size,
+            time.time() - start))
+
+    if fs == 'spiffs':
+        os.remove("bigmod.py")
+
+
+def import_module(name):
+    """Import given module and return it and the import time.
+
+    """
+
+    start = time.time()
+    module = __import__(name)
+    import_time = time.time() - start
+    del sys.modules[name]
+
+    return module, import_time
+
+
+def test_import_mpy_benchmark():
+    """Import the same module as source code and as precompiled
+    bytecode from the file system.
+
+    """
+
+    try:
+        import benchmod_data
+    except ImportError:
+        raise harness.TestCaseSkippedError()
+
+    with open("benchpy.py", "wb") as fout:
+        fout.write(benchmod_data.PY)
+
+    with open("benchmpy.mpy", "wb") as fout:
+        fout.write(benchmod_data.MPY)
+
+    benchpy, py_time = import_module('benchpy')
+    benchmpy, mpy_time = import_module('benchmpy')
+
+    assert benchpy.VALUE == benchmpy.VALUE == 1
+    assert benchpy.fibonacci(20) == benchmpy.fibonacci(20) == 6765
+    assert benchmpy.Accumulator(1).add(2) == 3
+
+    print('Imported {} bytes of source in {} s and {} bytes of bytecode '
+          'in {} s.'.format(len(benchmod_data.PY),
+                            py_time,
+                            len(benchmod_data.MPY),
+                            mpy_time))
+
+    if fs == 'spiffs':
+        os.remove("benchpy.py")
+        os.remove("benchmpy.mpy")
+
+
+def test_bytecode_cache():
+    """The first import compiles the module and stores the bytecode in
+    the cache, and later imports load it from the cache.
+
+    """
+
+    with open("cachemod.py", "w") as fout:
+        fout.write("VALUE = 1\n")
+
+    hits, misses = os.bytecode_cache_info()
+    cachemod, compile_time = import_module('cachemod')
+    assert cachemod.VALUE == 1
+    assert os.bytecode_cache_info() == (hits, misses + 1)
+
+    if fs == 'fat16':
+        assert 'CACHEMOD.MPY' in os.listdir('mpycache')
+
+    cachemod, cached_time = import_module('cachemod')
+    assert cachemod.VALUE == 1
+    assert os.bytecode_cache_info() == (hits + 1, misses + 1)
+
+    print('Imported in {} s when compiling and in {} s from the '
+          'cache.'.format(compile_time, cached_time))
+
+    # A modified source file of the same size is compiled again.
+    with open("cachemod.py", "w") as fout:
+        fout.write("VALUE = 2\n")
+
+    cachemod, _ = import_module('cachemod')
+    assert cachemod.VALUE == 2
+    assert os.bytecode_cache_info() == (hits + 1, misses + 2)
+
+    if fs == 'spiffs':
+        os.remove("cachemod.py")
+
+
+def import_package(names):
+    start = time.time()
+    pkg = __import__('pkg')
+    import_time = time.time() - start
+
+    for name in names:
+        del sys.modules[name]
+
+    return pkg, import_time
+
+
+def test_import_stat_cache_benchmark():
+    """Import a package tree searching a few sys.path entries, with and
+    without cached directory listings.
+
+    """
+
+    try:
+        os.mkdir('pkg')
+    except OSError:
+        pass
+
+    submodules = ['mod1', 'mod2', 'mod3', 'mod4']
+
+    with open('pkg/__init__.py', 'w') as fout:
+        for name in submodules:
+            fout.write('from . import {}\n'.format(name))
+
+    for name in submodules:
+        with open('pkg/{}.py'.format(name), 'w') as fout:
+            fout.write('VALUE = 1\n')
+
+    names = ['pkg'] + ['pkg.' + name for name in submodules]
+    saved_path = list(sys.path)
+    sys.path.extend(['lib', 'ext', ''])
+
+    try:
+        # Writing the files above emptied the cache.
+        hits, misses = os.import_stat_cache_info()
+        pkg, cold_time = import_package(names)
+        assert pkg.mod4.VALUE == 1
+        cold_hits, cold_misses = os.import_stat_cache_info()
+        assert cold_misses > misses
+
+        pkg, warm_time = import_package(names)
+        assert pkg.mod4.VALUE == 1
+        warm_hits, warm_misses = os.import_stat_cache_info()
+        assert warm_misses == cold_misses
+        assert warm_hits > cold_hits
+
+        print('Imported the package in {} s with {} directory reads and '
+              '{} cache hits, and in {} s with {} directory reads and '
+              '{} cache hits.'.format(cold_time,
+                                      cold_misses - misses,
+                                      cold_hits - hits,
+                                      warm_time,
+                                      warm_misses - cold_misses,
+                                      warm_hits - cold_hits))
+
+        # No directory is read again when looking up a missing module.
+        start = time.time()
+
+        for _ in range(10):
+            with assert_raises(ImportError):
+                __import__('missing')
+
+        print('Failed to import a missing module 10 times in {} s.'.format(
+            time.time() - start))
+        assert os.import_stat_cache_info()[1] == warm_misses
+    finally:
+        while sys.path:
+            sys.path.pop()
+
+        sys.path.extend(saved_path)
+
+
+def test_import_stat_cache_created_later():
+    """Import a module that was missing at the first lookup, in a
+    directory that did not exist at the first lookup.
+
+    """
+
+    saved_path = list(sys.path)
+    sys.path.append('late')
+
+    try:
+        with assert_raises(ImportError):
+            __import__('latemod')
+
+        os.mkdir('late')
+
+        with assert_raises(ImportError):
+            __import__('latemod')
+
+        with open('late/latemod.py', 'w') as fout:
+            fout.write('VALUE = 2\n')
+
+        latemod = __import__('latemod')
+        assert latemod.VALUE == 2
+        del sys.modules['latemod']
+    finally:
+        while sys.path:
+            sys.path.pop()
+
+        sys.path.extend(saved_path)
+
+
 TESTCASES = [
     (test_format, "test_format"),
     (test_directory, "test_directory"),
@@ -268,5 +512,10 @@ TESTCASES = [
     (test_listdir, "test_listdir"),
     (test_flush, "test_flush"),
     (test_print, "test_print"),
-    (test_system, "test_system")
+    (test_system, "test_system"),
+    (test_import_benchmark, "test_import_benchmark"),
+    (test_import_mpy_benchmark, "test_import_mpy_benchmark"),
+    (test_bytecode_cache, "test_bytecode_cache"),
+    (test_import_stat_cache_benchmark, "test_import_stat_cache_benchmark"),
+    (test_import_stat_cache_created_later, "test_import_stat_cache_created_later")
 ]
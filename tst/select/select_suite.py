@@ -29,6 +29,7 @@
 #
 
 
+import gc
 import select
 import board
 from sync import Event, Queue
@@ -91,6 +92,130 @@ def test_poll():
     assert queue.read(3) == b'foo'
 
 
+def test_poll_multiple():
+    poll = select.poll()
+    queue = Queue()
+    event = Event()
+
+    poll.register(queue)
+    poll.register(event)
+
+    # Both channels are returned in a single poll.
+    event.write(0x1)
+    queue.write(b'foo')
+    assert poll.poll() == [(queue, select.POLLIN), (event, select.POLLIN)]
+    assert event.read(0x1) == 0x1
+    assert poll.poll() == [(queue, select.POLLIN)]
+    assert queue.read(3) == b'foo'
+    assert poll.poll(0.01) == []
+
+    # Channels are always writable.
+    poll.modify(event, select.POLLIN | select.POLLOUT)
+    assert poll.poll(0.01) == [(event, select.POLLOUT)]
+    event.write(0x1)
+    assert poll.poll() == [(event, select.POLLIN | select.POLLOUT)]
+    assert event.read(0x1) == 0x1
+
+    # Register again to modify the event mask.
+    poll.register(event, select.POLLIN)
+    assert poll.poll(0.01) == []
+
+    # A channel with an empty event mask does not wake up the poller
+    # until its mask is set again.
+    poll.modify(event, 0)
+    event.write(0x1)
+    assert poll.poll(0.01) == []
+    poll.modify(event, select.POLLIN)
+    assert poll.poll() == [(event, select.POLLIN)]
+    assert event.read(0x1) == 0x1
+
+    with assert_raises(OSError):
+        poll.modify(Queue(), select.POLLIN)
+
+
+def test_poll_many_channels():
+    poll = select.poll()
+    queues = [Queue() for _ in range(40)]
+
+    for queue in queues:
+        poll.register(queue)
+
+    for queue in queues[::3]:
+        queue.write(b'a')
+
+    assert poll.poll() == [(queue, select.POLLIN) for queue in queues[::3]]
+
+    for queue in queues[::3]:
+        assert queue.read(1) == b'a'
+
+    for queue in queues:
+        poll.unregister(queue)
+
+    assert poll.poll(0.01) == []
+
+
+def test_ipoll():
+    poll = select.poll()
+    queue = Queue()
+    event = Event()
+
+    poll.register(queue)
+    poll.register(event)
+
+    # Timeout waiting for event.
+    assert list(poll.ipoll(0.01)) == []
+
+    # The same tuple object is reused for all channels.
+    event.write(0x1)
+    queue.write(b'foo')
+    ready = []
+    first = None
+
+    for result in poll.ipoll():
+        if first is None:
+            first = result
+
+        assert result is first
+        ready.append((result[0], result[1]))
+
+    assert ready == [(queue, select.POLLIN), (event, select.POLLIN)]
+    assert event.read(0x1) == 0x1
+    assert queue.read(3) == b'foo'
+
+    # The poll object is only iterable as returned by ipoll().
+    with assert_raises(TypeError, "iterate over ipoll()"):
+        for _ in poll:
+            pass
+
+
+def test_ipoll_allocation():
+    poll = select.poll()
+    event = Event()
+    poll.register(event)
+    count = 0
+    i = 0
+
+    gc.collect()
+    before = gc.mem_alloc()
+
+    # A while loop as range() allocates memory.
+    while i < 10000:
+        event.write(0x1)
+
+        for obj, revents in poll.ipoll(0):
+            event.read(0x1)
+            count += 1
+
+        i += 1
+
+    after = gc.mem_alloc()
+
+    print('ipoll(): {} bytes allocated in 10000 polls.'.format(after - before))
+
+    assert count == 10000
+    assert after == before
+
+
 def test_bad_arguments():
     poll = select.poll()
 
@@ -105,5 +230,9 @@ TESTCASES = [
     (test_help, "test_help"),
     (test_register_unregister, "test_register_unregister"),
     (test_poll, "test_poll"),
+    (test_poll_multiple, "test_poll_multiple"),
+    (test_poll_many_channels, "test_poll_many_channels"),
+    (test_ipoll, "test_ipoll"),
+    (test_ipoll_allocation, "test_ipoll_allocation"),
     (test_bad_arguments, "test_bad_arguments")
 ]
@@ -218,6 +218,34 @@ def test_smoke():
         print('thrd_get_env(CWD): ', kernel.thrd_get_env('CWD'))
 
 
+def test_stdout_benchmark():
+    """Measure standard output throughput.
+
+    """
+
+    if 'Linux' not in os.uname().machine:
+        raise harness.TestCaseSkippedError()
+
+    line = 70 * 'x'
+    start = time.time()
+
+    for _ in range(200):
+        print(line)
+
+    sys.stdout.write(line)
+    sys.stdout.flush()
+    print()
+
+    elapsed = time.time() - start
+    size = 201 * (len(line) + 2)
+
+    print('Wrote {} bytes to stdout in {} s ({} bytes/s).'.format(
+        size,
+        elapsed,
+        size / elapsed if elapsed > 0 else 'inf'))
+
+
 TESTCASES = [
-    (test_smoke, "test_smoke")
+    (test_smoke, "test_smoke"),
+    (test_stdout_benchmark, "test_stdout_benchmark")
 ]
@@ -29,6 +29,9 @@
 #
 
 
+import gc
+import time
+import errno
 import select
 import socket
 from harness import assert_raises
@@ -45,6 +48,32 @@ def test_tcp_client():
     assert sock.send(b'send()') == 6
     assert sock.sendall(b'send()') == 6
     assert sock.recv(6) == b'recv()'
+    buf = bytearray(6)
+    assert sock.recv_into(buf) == 6
+    assert buf == b'recv()'
+    buf = bytearray(b'xxxxxxxx')
+    assert sock.recv_into(buf, 6) == 6
+    assert buf == b'recv()xx'
+    buf = bytearray(6)
+    assert sock.readinto(memoryview(buf)) == 6
+    assert buf == b'recv()'
+    sock.close()
+    assert socket_stub.reset_failed() == 0
+
+
+def test_tcp_client_sendall_sendv():
+    socket_stub.set_send([
+        (b'foobar', 4),
+        (b'ar', 2),
+        b'HTTP/1.1 200 OK\r\n\r\n',
+        (b'body', 1),
+        b'ody'
+    ])
+
+    sock = socket.socket()
+    sock.connect(("192.168.0.1", 8080))
+    assert sock.sendall(b'foobar') == 6
+    assert sock.sendv([b'HTTP/1.1 200 OK\r\n\r\n', bytearray(b'body')]) == 23
     sock.close()
     assert socket_stub.reset_failed() == 0
 
@@ -73,12 +102,45 @@ def test_udp():
     buf, fromaddr = sock.recvfrom(1024)
     assert buf == b'recvfrom()'
     assert fromaddr == (b'192.168.0.1', 8080)
+    buf = bytearray(1024)
+    nbytes, fromaddr = sock.recvfrom_into(buf)
+    assert nbytes == 10
+    assert buf[:nbytes] == b'recvfrom()'
+    assert fromaddr == (b'192.168.0.1', 8080)
     assert sock.sendto(b'123', fromaddr) == 3
     assert sock.sendto(b'456', fromaddr) == 0
     assert sock.sendto(b'789', fromaddr) == 0
     assert socket_stub.reset_failed() == 0
 
 
+def test_udp_recvmmsg():
+    socket_stub.set_recvfrom([b'a', b'bc', b'def'])
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    buffers = [bytearray(1024), bytearray(1024)]
+    sizes = [0, 0]
+    addresses = [None, None]
+
+    # Fill both buffers in one call.
+    assert sock.recvmmsg(buffers, sizes, addresses) == 2
+    assert sizes == [1, 2]
+    assert buffers[0][:1] == b'a'
+    assert buffers[1][:2] == b'bc'
+    assert addresses[0] == (b'192.168.0.1', 8080)
+    assert addresses[1] is addresses[0]
+
+    # Only one datagram left.
+    assert sock.recvmmsg(buffers, sizes, addresses) == 1
+    assert sizes[0] == 3
+    assert buffers[0][:3] == b'def'
+
+    # The address tuple is cached.
+    nbytes, fromaddr = sock.recvfrom_into(buffers[0])
+    assert fromaddr is addresses[0]
+
+    with assert_raises(ValueError, "lists too short"):
+        sock.recvmmsg(buffers, [0], addresses)
+
+
 def test_select():
     poll = select.poll()
     tcp = socket.socket()
@@ -93,6 +155,48 @@ def test_select():
     assert socket_stub.reset_failed() == 0
 
 
+def test_timeout():
+    sock = socket.socket()
+    sock.connect(("192.168.0.1", 8080))
+
+    # No data is available in the stub, so a non-blocking socket
+    # fails immediately.
+    sock.setblocking(False)
+
+    try:
+        sock.recv(6)
+        assert False
+    except OSError as e:
+        assert e.args[0] == errno.EAGAIN
+
+    try:
+        sock.recv_into(bytearray(6))
+        assert False
+    except OSError as e:
+        assert e.args[0] == errno.EAGAIN
+
+    # Timeout waiting for data.
+    sock.settimeout(0.01)
+
+    try:
+        sock.recv(6)
+        assert False
+    except OSError as e:
+        assert e.args[0] == errno.ETIMEDOUT
+
+    # Blocking sockets read from the stub.
+    sock.settimeout(None)
+    assert sock.recv(6) == b'recv()'
+    sock.setblocking(True)
+    assert sock.recv(6) == b'recv()'
+
+    with assert_raises(ValueError, "timeout value out of range"):
+        sock.settimeout(-1)
+
+    sock.close()
+    assert socket_stub.reset_failed() == 0
+
+
 def test_errors():
     # Failed accept.
     socket_stub.set_accept(-1)
@@ -152,7 +256,81 @@ def test_errors():
     sock.close()
     assert socket_stub.reset_failed() == 0
 
+    # Failed sendall and sendv.
+    socket_stub.set_send([(b'foobar', 3), -1, 0])
+
+    sock = socket.socket()
+    sock.connect(("192.168.0.1", 8080))
+
+    with assert_raises(OSError, 'socket sendall failed'):
+        sock.sendall(b'foobar')
+
+    with assert_raises(OSError, 'socket sendv failed'):
+        sock.sendv([b'foo', b'bar'])
+
+    sock.close()
+    assert socket_stub.reset_failed() == 0
+
     
+def receive_megabyte(sock, buf):
+    """Receive one megabyte in 1 kB chunks, using recv() if buf is None
+    and recv_into() otherwise. Returns the number of garbage
+    collections and the number of bytes allocated on the heap during
+    the transfer.
+
+    """
+
+    chunk = 1024 * b'x'
+    collections = 0
+    allocated = 0
+
+    for _ in range(16):
+        socket_stub.set_recv(64 * [chunk])
+        i = 0
+        before = gc.mem_alloc()
+
+        # A while loop as range() allocates memory.
+        if buf is None:
+            while i < 64:
+                sock.recv(1024)
+                i += 1
+        else:
+            while i < 64:
+                sock.recv_into(buf)
+                i += 1
+
+        after = gc.mem_alloc()
+
+        if after < before:
+            collections += 1
+        else:
+            allocated += after - before
+
+    return collections, allocated
+
+
+def test_recv_into_benchmark():
+    sock = socket.socket()
+    sock.connect(("192.168.0.1", 8080))
+    buf = bytearray(1024)
+
+    for method, buf in [('recv', None), ('recv_into', buf)]:
+        start = time.time()
+        collections, allocated = receive_megabyte(sock, buf)
+        print('{}(): {} collection(s) and {} bytes allocated per MB '
+              'in {} s.'.format(method,
+                                collections,
+                                allocated,
+                                time.time() - start))
+
+    # Receiving into a preallocated buffer must not allocate memory.
+    assert collections == 0
+    assert allocated == 0
+
+    sock.close()
+    assert socket_stub.reset_failed() == 0
+
+
 def test_bad_arguments():
     # Bad socket family.
     with assert_raises(OSError):
@@ -162,15 +340,27 @@ def test_bad_arguments():
     with assert_raises(OSError):
         socket.socket(socket.AF_INET, -1)
 
+    # Negative number of bytes to receive.
+    sock = socket.socket()
+
+    with assert_raises(ValueError, "negative buffersize"):
+        sock.recv_into(bytearray(1), -1)
+
+    sock.close()
+
     assert socket_stub.reset_failed() == 0
 
 
 TESTCASES = [
     (test_print, "test_print"),
     (test_tcp_client, "test_tcp_client"),
+    (test_tcp_client_sendall_sendv, "test_tcp_client_sendall_sendv"),
     (test_tcp_server, "test_tcp_server"),
     (test_udp, "test_udp"),
+    (test_udp_recvmmsg, "test_udp_recvmmsg"),
     (test_select, "test_select"),
+    (test_timeout, "test_timeout"),
     (test_errors, "test_errors"),
+    (test_recv_into_benchmark, "test_recv_into_benchmark"),
     (test_bad_arguments, "test_bad_arguments")
 ]
@@ -178,6 +178,21 @@ static ssize_t write(void *self_p,
 
 static size_t size(void *self_p)
 {
+    /* Queued receive data is available without blocking. */
+    if (MP_STATE_VM(socket_stub_recv_obj) != mp_const_none) {
+        return (1);
+    }
+
+    return (0);
+}
+
+static size_t udp_size(void *self_p)
+{
+    /* Queued datagrams are available without blocking. */
+    if (MP_STATE_VM(socket_stub_recvfrom_obj) != mp_const_none) {
+        return (1);
+    }
+
     return (0);
 }
 
@@ -193,7 +208,7 @@ int socket_open_tcp(struct socket_t *self_p)
 
 int socket_open_udp(struct socket_t *self_p)
 {
-    return (0);
+    return (chan_init(&self_p->base, read, write, udp_size));
 }
 
 int socket_open_raw(struct socket_t *self_p)
@@ -30,6 +30,30 @@
 
 #include "pumbaa.h"
 
+#if CONFIG_PUMBAA_SSL_SESSION_CACHE == 1
+
+#include "mbedtls/ssl.h"
+
+static void *session_cache_p = NULL;
+static int (*session_cache_get)(void *, mbedtls_ssl_session *) = NULL;
+static int (*session_cache_set)(void *, const mbedtls_ssl_session *) = NULL;
+
+void mbedtls_ssl_conf_session_cache(
+    mbedtls_ssl_config *conf_p,
+    void *cache_p,
+    int (*get)(void *, mbedtls_ssl_session *),
+    int (*set)(void *, const mbedtls_ssl_session *))
+{
+    session_cache_p = cache_p;
+    session_cache_get = get;
+    session_cache_set = set;
+}
+
+#endif
+
+/* Pass reads and writes through to the wrapped socket if set. */
+static int passthrough = 0;
+
 int ssl_module_init()
 {
     return (0);
@@ -80,6 +104,8 @@ int ssl_socket_open(struct ssl_socket_t *self_p,
     BTASSERT(context_p != NULL);
     BTASSERT(socket_p != NULL);
 
+    self_p->socket_p = socket_p;
+
     return (chan_init(&self_p->base,
                       (chan_read_fn_t)ssl_socket_read,
                       (chan_write_fn_t)ssl_socket_write,
@@ -97,6 +123,10 @@ ssize_t ssl_socket_write(struct ssl_socket_t *self_p,
 {
     BTASSERT(self_p != NULL);
 
+    if (passthrough == 1) {
+        return (chan_write(self_p->socket_p, buf_p, size));
+    }
+
     if (size == 5) {
         if (memcmp(buf_p, "hello", 5) != 0) {
             return (-1);
@@ -118,6 +148,10 @@ ssize_t ssl_socket_read(struct ssl_socket_t *self_p,
 {
     BTASSERT(self_p != NULL);
 
+    if (passthrough == 1) {
+        return (chan_read(self_p->socket_p, buf_p, size));
+    }
+
     if (size == 7) {
         memcpy(buf_p, "goodbye", 7);
 
@@ -173,12 +207,92 @@ static mp_obj_t module_init(void)
 
 static MP_DEFINE_CONST_FUN_OBJ_0(module_init_obj, module_init);
 
+/**
+ * Pass reads and writes of SSL sockets through to the wrapped sockets
+ * if given value is true. Records pending on a wrapped socket are not
+ * included in the SSL socket size, as for real SSL sockets.
+ */
+static mp_obj_t module_set_passthrough(mp_obj_t enabled_in)
+{
+    passthrough = mp_obj_is_true(enabled_in);
+
+    return (mp_const_none);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_1(module_set_passthrough_obj,
+                                 module_set_passthrough);
+
+#if CONFIG_PUMBAA_SSL_SESSION_CACHE == 1
+
+/**
+ * Perform the session cache part of a server side handshake with a
+ * client resuming given session id, using the callbacks of the last
+ * context given a session cache. Returns True if the session was
+ * resumed and False if it was added to the cache after a full
+ * handshake.
+ */
+static mp_obj_t module_handshake(mp_obj_t session_id_in)
+{
+    mbedtls_ssl_session session;
+    mp_buffer_info_t buffer_info;
+    unsigned char master[sizeof(session.master)];
+
+    mp_get_buffer_raise(session_id_in, &buffer_info, MP_BUFFER_READ);
+    BTASSERT(session_cache_get != NULL);
+    BTASSERT(buffer_info.len <= sizeof(session.id));
+
+    /* The master secret is derived from the session id. */
+    memset(&master[0], 0, sizeof(master));
+    memcpy(&master[0], buffer_info.buf, buffer_info.len);
+
+    memset(&session, 0, sizeof(session));
+    session.ciphersuite = 0x9d;
+    session.id_len = buffer_info.len;
+    memcpy(&session.id[0], buffer_info.buf, buffer_info.len);
+
+    if (session_cache_get(session_cache_p, &session) == 0) {
+        BTASSERT(memcmp(&session.master[0], &master[0], sizeof(master)) == 0);
+
+        return (mp_const_true);
+    }
+
+    memcpy(&session.master[0], &master[0], sizeof(master));
+    BTASSERT(session_cache_set(session_cache_p, &session) == 0);
+
+    return (mp_const_false);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_1(module_handshake_obj, module_handshake);
+
+/**
+ * Set the system time to given number of seconds.
+ */
+static mp_obj_t module_set_time(mp_obj_t seconds_in)
+{
+    struct time_t now;
+
+    now.seconds = mp_obj_get_int(seconds_in);
+    now.nanoseconds = 0;
+    time_set(&now);
+
+    return (mp_const_none);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_1(module_set_time_obj, module_set_time);
+
+#endif
+
 /**
  * The module globals table.
  */
 static const mp_rom_map_elem_t module_ssl_stub_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_ssl_stub) },
     { MP_ROM_QSTR(MP_QSTR___init__), MP_ROM_PTR(&module_init_obj) },
+    { MP_ROM_QSTR(MP_QSTR_set_passthrough), MP_ROM_PTR(&module_set_passthrough_obj) },
+#if CONFIG_PUMBAA_SSL_SESSION_CACHE == 1
+    { MP_ROM_QSTR(MP_QSTR_handshake), MP_ROM_PTR(&module_handshake_obj) },
+    { MP_ROM_QSTR(MP_QSTR_set_time), MP_ROM_PTR(&module_set_time_obj) },
+#endif
 };
 
 static MP_DEFINE_CONST_DICT(module_ssl_stub_globals, module_ssl_stub_globals_table);
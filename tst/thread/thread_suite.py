@@ -30,10 +30,12 @@
 
 
 import os
+import time
 import _thread
 from sync import Event
 import harness
 import gc
+import micropython
 
 EVENT = Event()
 
@@ -52,15 +54,101 @@ def test_start():
     assert EVENT.read(mask) == mask
 
 
+def test_lock():
+    lock = _thread.allocate_lock()
+    assert lock.acquire() == True
+    assert lock.acquire(0) == False
+    lock.release()
+    assert lock.acquire(0) == True
+    lock.release()
+
+
+def parked_thread_main(event, mask):
+    EVENT.write(mask)
+    event.read(mask)
+    EVENT.write(mask)
+
+
+def call_overhead():
+    """Returns the average time in microseconds of an empty function
+    call. Each call looks up the calling thread's state.
+
+    """
+
+    def empty():
+        pass
+
+    i = 0
+    start = time.time()
+
+    # A while loop as range() allocates memory.
+    while i < 10000:
+        empty()
+        i += 1
+
+    return (time.time() - start) * 100
+
+
+def call_overhead_thread_main(results, index):
+    results[index] = call_overhead()
+    EVENT.write(0x100)
+
+
+def spawned_call_overhead():
+    """Returns the average time in microseconds of an empty function
+    call in a spawned thread, which is not the main thread.
+
+    """
+
+    results = [None]
+    _thread.start_new_thread(call_overhead_thread_main, (results, 0))
+    assert EVENT.read(0x100) == 0x100
+
+    return results[0]
+
+
+def test_state_lookup_benchmark():
+    before = call_overhead()
+    spawned_before = spawned_call_overhead()
+    parked = Event()
+
+    # Start 8 threads parked on an event, each waiting for its own
+    # bit.
+    for i in range(8):
+        _thread.start_new_thread(parked_thread_main, (parked, 1 << i))
+        assert EVENT.read(1 << i) == (1 << i)
+
+    after = call_overhead()
+    spawned_after = spawned_call_overhead()
+
+    print('Call overhead with 1 thread: {} us.'.format(before))
+    print('Call overhead with 9 threads: {} us.'.format(after))
+    print('Call overhead in a spawned thread with 2 threads: {} us.'.format(
+        spawned_before))
+    print('Call overhead in a spawned thread with 10 threads: {} us.'.format(
+        spawned_after))
+
+    # Wake up all threads and wait for them to exit.
+    parked.write(0xff)
+
+    for i in range(8):
+        assert EVENT.read(1 << i) == (1 << i)
+
+
 def test_gc():
     if os.uname().machine != "Linux with Linux":
         print('Free memory before gc:', gc.mem_free())
         gc.collect()
         print('Free memory after gc:', gc.mem_free())
 
+    # Includes the number of stack bytes scanned in other threads.
+    micropython.mem_info()
+
 
 TESTCASES = [
     (test_print, "test_print"),
     (test_start, "test_start"),
+    (test_lock, "test_lock"),
+    (test_state_lookup_benchmark, "test_state_lookup_benchmark"),
     (test_gc, "test_gc")
 ]
@@ -0,0 +1,45 @@
+/**
+ * @section License
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016-2017, Erik Moqvist
+ * 
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * This file is part of the Pumbaa project.
+ */
+
+#ifndef __CONFIG_H__
+#define __CONFIG_H__
+
+#include "stubs.h"
+
+#define MICROPY_PORT_BUILTIN_MODULES_EXTRA      \
+    SOCKET_STUB_BUILTIN_MODULE
+
+#define MICROPY_PORT_ROOT_POINTERS_EXTRA        \
+    SOCKET_STUB_ROOT_POINTERS
+
+/* Changes of the default Simba configuration. */
+#include "simba_config.h"
+
+#endif
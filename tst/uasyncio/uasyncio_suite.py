@@ -0,0 +1,343 @@
+#
+# @section License
+#
+# The MIT License (MIT)
+#
+# Copyright (c) 2016-2017, Erik Moqvist
+#
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation
+# files (the "Software"), to deal in the Software without
+# restriction, including without limitation the rights to use, copy,
+# modify, merge, publish, distribute, sublicense, and/or sell copies
+# of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+# BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+# ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+# CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+# This file is part of the Pumbaa project.
+#
+
+import os
+import gc
+import time
+import _thread
+import socket
+import uasyncio
+from sync import Event, Queue
+import harness
+from harness import assert_raises
+import socket_stub
+
+
+def test_sleep():
+    loop = uasyncio.EventLoop()
+    order = []
+
+    def sleeper(name, delay):
+        yield from uasyncio.sleep(delay)
+        order.append(name)
+
+    loop.create_task(sleeper('c', 0.03))
+    loop.create_task(sleeper('a', 0.01))
+    loop.create_task(sleeper('b', 0.02))
+    loop.run_forever()
+
+    assert order == ['a', 'b', 'c']
+
+
+def test_run_until_complete():
+    loop = uasyncio.EventLoop()
+
+    def add(a, b):
+        yield
+        return a + b
+
+    def main():
+        value = yield from add(1, 2)
+        return value * 2
+
+    assert loop.run_until_complete(main()) == 6
+
+
+def test_channels():
+    loop = uasyncio.EventLoop()
+    queue = Queue()
+    event = Event()
+    received = []
+
+    def reader():
+        yield from uasyncio.wait_readable(queue)
+        received.append(queue.read(3))
+        yield from uasyncio.wait_readable(event)
+        received.append(event.read(0x1))
+
+    def writer():
+        yield from uasyncio.sleep(0.01)
+        queue.write(b'foo')
+        yield from uasyncio.sleep(0.01)
+        event.write(0x1)
+
+    loop.create_task(reader())
+    loop.create_task(writer())
+    loop.run_forever()
+
+    assert received == [b'foo', 0x1]
+
+
+def test_bad_arguments():
+    loop = uasyncio.EventLoop()
+    queue = Queue()
+
+    def waiter():
+        yield from uasyncio.wait_readable(queue)
+
+    loop.create_task(waiter())
+    loop.create_task(waiter())
+
+    with assert_raises(OSError, 'channel already waited on'):
+        loop.run_forever()
+
+
+def test_failed_task():
+    loop = uasyncio.EventLoop()
+    done = []
+
+    def failing():
+        yield
+        raise ValueError('failed')
+
+    def working():
+        yield from uasyncio.sleep(0.01)
+        done.append(True)
+
+    # The failed task is reported and dropped.
+    loop.create_task(failing())
+    loop.create_task(working())
+    loop.run_forever()
+
+    assert done == [True]
+
+    with assert_raises(ValueError, 'failed'):
+        loop.run_until_complete(failing())
+
+
+def test_stream_reader_writer():
+    loop = uasyncio.EventLoop()
+    sock = socket.socket()
+    sock.setblocking(False)
+    reader = uasyncio.StreamReader(sock)
+    writer = uasyncio.StreamWriter(sock)
+    received = []
+
+    # The reader waits for data while the writer waits on the same
+    # socket.
+    def read_coro():
+        received.append((yield from reader.readexactly(5)))
+        received.append((yield from reader.read()))
+
+    def write_coro():
+        yield from writer.awrite(b'hello')
+
+    def feed_coro():
+        yield from uasyncio.sleep(0.01)
+        socket_stub.set_recv([b'hello', 0])
+
+    socket_stub.set_send([b'hello'])
+    loop.create_task(read_coro())
+    loop.create_task(write_coro())
+    loop.create_task(feed_coro())
+    loop.run_forever()
+
+    # The end of stream is an empty read.
+    assert received == [b'hello', b'']
+    assert socket_stub.reset_failed() == 0
+
+
+def test_open_connection():
+    loop = uasyncio.EventLoop()
+
+    def client():
+        reader, writer = yield from uasyncio.open_connection('192.168.0.1',
+                                                             8080)
+        data = yield from reader.read(5)
+        yield from writer.awrite(data)
+        yield from writer.aclose()
+
+        return data
+
+    socket_stub.set_recv([b'hello'])
+    socket_stub.set_send([b'hello'])
+    socket_stub.set_close([0])
+    assert loop.run_until_complete(client()) == b'hello'
+    assert socket_stub.reset_failed() == 0
+
+    # A failed connect is raised in the coroutine.
+    socket_stub.set_connect([-1])
+
+    with assert_raises(OSError, 'socket connect failed'):
+        loop.run_until_complete(client())
+
+    assert socket_stub.reset_failed() == 0
+
+
+def test_start_server():
+    loop = uasyncio.get_event_loop()
+    received = []
+
+    def client(reader, writer):
+        received.append((yield from reader.read(5)))
+        received.append((yield from reader.read()))
+        yield from writer.awrite(b'olleh')
+        yield from writer.aclose()
+        loop.stop()
+
+    # The second accept fails, which stops the server task and closes
+    # the listener.
+    socket_stub.set_recv([b'hello', 0])
+    socket_stub.set_send([b'olleh'])
+    socket_stub.set_accept([0, -1])
+    socket_stub.set_close([0, 0])
+    loop.create_task(uasyncio.start_server(client, '192.168.0.1', 8080))
+    loop.run_forever()
+
+    assert received == [b'hello', b'']
+    assert socket_stub.reset_failed() == 0
+
+
+def collect():
+    # Garbage collection is not supported on Linux.
+    if os.uname().machine != "Linux with Linux":
+        gc.collect()
+
+
+def echo_coro(rx, tx):
+    while True:
+        yield from uasyncio.wait_readable(rx)
+        data = rx.read(1)
+
+        if data == b'q':
+            break
+
+        tx.write(data)
+
+
+def ping_coro(connections, reply, latencies):
+    for rx in connections:
+        start = time.time()
+        rx.write(b'x')
+        yield from uasyncio.wait_readable(reply)
+        reply.read(1)
+        latencies.append(time.time() - start)
+
+    for rx in connections:
+        rx.write(b'q')
+
+
+def echo_thread(rx, tx):
+    tx.write(rx.read(1))
+
+
+def benchmark_coroutines(number_of_connections):
+    """Returns the number of bytes used per connection and the average
+    round trip time.
+
+    """
+
+    loop = uasyncio.EventLoop()
+    reply = Queue()
+    latencies = []
+
+    collect()
+    before = gc.mem_free()
+    connections = []
+
+    for _ in range(number_of_connections):
+        rx = Queue()
+        connections.append(rx)
+        loop.create_task(echo_coro(rx, reply))
+
+    # Let all coroutines park on their channel.
+    loop.run_once()
+    used = (before - gc.mem_free()) // number_of_connections
+
+    loop.create_task(ping_coro(connections, reply, latencies))
+    loop.run_forever()
+
+    return used, sum(latencies) / len(latencies)
+
+
+def benchmark_threads(number_of_connections, stack_size):
+    """Same as benchmark_coroutines(), but with one thread per
+    connection. Thread stacks are not allocated on the Python heap, so
+    the stack size is added to the used memory.
+
+    """
+
+    reply = Queue()
+    latencies = []
+
+    _thread.stack_size(stack_size)
+    collect()
+    before = gc.mem_free()
+    connections = []
+
+    for _ in range(number_of_connections):
+        rx = Queue()
+        connections.append(rx)
+        _thread.start_new_thread(echo_thread, (rx, reply))
+
+    used = (before - gc.mem_free()) // number_of_connections
+    used += stack_size
+
+    for rx in connections:
+        start = time.time()
+        rx.write(b'x')
+        reply.read(1)
+        latencies.append(time.time() - start)
+
+    _thread.stack_size(0)
+
+    return used, sum(latencies) / len(latencies)
+
+
+def test_benchmark():
+    """Compare connection density and round trip latency of coroutines
+    to one thread per connection.
+
+    """
+
+    coroutines_used, coroutines_latency = benchmark_coroutines(100)
+    threads_used, threads_latency = benchmark_threads(4, 4096)
+
+    print('Coroutines: {} bytes per connection, {} s round trip.'.format(
+        coroutines_used,
+        coroutines_latency))
+    print('Threads:    {} bytes per connection, {} s round trip.'.format(
+        threads_used,
+        threads_latency))
+
+    assert coroutines_used < threads_used
+
+
+TESTCASES = [
+    (test_sleep, "test_sleep"),
+    (test_run_until_complete, "test_run_until_complete"),
+    (test_channels, "test_channels"),
+    (test_bad_arguments, "test_bad_arguments"),
+    (test_failed_task, "test_failed_task"),
+    (test_stream_reader_writer, "test_stream_reader_writer"),
+    (test_open_connection, "test_open_connection"),
+    (test_start_server, "test_start_server"),
+    (test_benchmark, "test_benchmark")
+]